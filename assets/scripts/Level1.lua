@@ -2605,10 +2605,10 @@ Level = {
                 transform = {
                     position = { x = 685, y = 300 },
                     scale = { x = 1.0, y = 1.0 },
-                    rotation = -10.0, -- degrees
+                    rotation = 0.0, -- degrees
                 },
                 rigidbody = {
-                    velocity = { x = -5.5 , y = -35.0 }
+                    velocity = { x = 0.0, y = -35.0 }
                 },
                 sprite = {
                     texture_asset_id = "su27-texture",
@@ -2627,6 +2627,36 @@ Level = {
                 },
                 health = {
                     health_percentage = 100
+                },
+                coroutine_script = {
+                    [0] =
+                    function(entity)
+                        -- this coroutine patrols the jet up and down the river, holding at each end
+                        while true do
+                            -- fly up until it's near the top of its beat
+                            set_rotation(entity, 0)
+                            set_velocity(entity, 0, -35)
+                            wait_until(function()
+                                local x, y = get_position(entity)
+                                return y < 150
+                            end)
+
+                            -- hold for a few seconds, then tell the bomber it can go
+                            set_velocity(entity, 0, 0)
+                            wait(4)
+                            emit_event("su27_patrol_turned")
+
+                            -- fly back down and hold again
+                            set_rotation(entity, 180)
+                            set_velocity(entity, 0, 35)
+                            wait_until(function()
+                                local x, y = get_position(entity)
+                                return y > 450
+                            end)
+                            set_velocity(entity, 0, 0)
+                            wait(4)
+                        end
+                    end
                 }
             }
         },
@@ -2639,6 +2669,9 @@ Level = {
                     scale = { x = 1.0, y = 1.0 },
                     rotation = 0.0, -- degrees
                 },
+                rigidbody = {
+                    velocity = { x = 0.0, y = 0.0 }
+                },
                 sprite = {
                     texture_asset_id = "bomber-texture",
                     width = 32,
@@ -2656,6 +2689,26 @@ Level = {
                 },
                 health = {
                     health_percentage = 100
+                },
+                coroutine_script = {
+                    [0] =
+                    function(entity)
+                        -- the bomber sits on the ground until the SU-27 first turns back
+                        wait_event("su27_patrol_turned")
+                        set_rotation(entity, 0)
+                        set_velocity(entity, 0, -20)
+
+                        -- climbs out for ten seconds, then patrols left and right
+                        wait(10)
+                        while true do
+                            set_rotation(entity, 90)
+                            set_velocity(entity, 20, 0)
+                            wait(3)
+                            set_rotation(entity, 270)
+                            set_velocity(entity, -20, 0)
+                            wait(3)
+                        end
+                    end
                 }
             }
         },
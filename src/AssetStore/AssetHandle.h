@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+// AssetHandle
+////////////////////////////////////////////////////////////////////////////////
+// What components keep instead of asset id strings. The low bits index the
+// AssetStore's arrays (0 = no asset), the high bits hold the generation of the
+// slot when it was handed out, so handles kept after their asset is evicted (or
+// ClearAssets) resolve to nothing instead of to whatever reuses the slot.
+// The tag only keeps texture and font handles from being mixed up.
+////////////////////////////////////////////////////////////////////////////////
+template <typename TTag>
+struct AssetHandle {
+	static const int INDEX_BITS = 20;
+	static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+	uint32_t value = 0;
+
+	AssetHandle() = default;
+	AssetHandle(uint32_t index, uint32_t generation): value((generation << INDEX_BITS) | (index & INDEX_MASK)) {}
+
+	uint32_t GetIndex() const { return value & INDEX_MASK; }
+	uint32_t GetGeneration() const { return value >> INDEX_BITS; }
+	bool IsValid() const { return value != 0; }
+
+	bool operator==(const AssetHandle& other) const { return value == other.value; }
+	bool operator!=(const AssetHandle& other) const { return value != other.value; }
+};
+
+struct TextureAssetTag;
+struct FontAssetTag;
+typedef AssetHandle<TextureAssetTag> TextureHandle;
+typedef AssetHandle<FontAssetTag> FontHandle;
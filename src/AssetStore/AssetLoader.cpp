@@ -0,0 +1,134 @@
+#include "AssetLoader.h"
+#include "../Logger/Logger.h"
+#include <SDL2/SDL_image.h>
+#include <fstream>
+#include <iterator>
+
+AssetLoader::AssetLoader(ThreadPool& threadPool): threadPool(threadPool) {
+	pack = nullptr;
+	numAssets = 0;
+	numDecoded = 0;
+	decodesDoneFuture = decodesDone.get_future().share();
+	isStarted = false;
+}
+
+AssetLoader::~AssetLoader() {
+	// jobs still write into this loader, let them finish
+	if (isStarted) {
+		decodesDoneFuture.wait();
+	}
+	for (auto surface: surfaces) {
+		SDL_FreeSurface(surface);
+	}
+}
+
+void AssetLoader::OnDecoded() {
+	if (numDecoded.fetch_add(1) + 1 == numAssets) {
+		decodesDone.set_value();
+	}
+}
+
+LevelAssets AssetLoader::Start(AssetStore& assetStore, const std::vector<TextureAssetInfo>& textureAssets, const std::vector<FontAssetInfo>& fontAssets) {
+	LevelAssets acquired;
+	if (isStarted) {
+		Logger::Err("AssetLoader already started");
+		return acquired;
+	}
+	isStarted = true;
+	pack = assetStore.GetPack();
+
+	// handles exist before the data does, so entities can be created meanwhile;
+	// only what the cache does not already hold gets decoded
+	for (const auto& asset: textureAssets) {
+		TextureHandle handle = assetStore.AcquireTexture(asset);
+		acquired.textures.push_back(handle);
+		if (!assetStore.IsTextureLoaded(handle)) {
+			this->textureAssets.push_back(asset);
+		}
+	}
+	for (const auto& asset: fontAssets) {
+		FontHandle handle = assetStore.AcquireFont(asset);
+		acquired.fonts.push_back(handle);
+		if (!assetStore.IsFontLoaded(handle)) {
+			this->fontAssets.push_back(asset);
+		}
+	}
+	surfaces.assign(this->textureAssets.size(), nullptr);
+	fontData.assign(this->fontAssets.size(), std::vector<char>());
+	fontViews.assign(this->fontAssets.size(), nullptr);
+	fontViewSizes.assign(this->fontAssets.size(), 0);
+	numAssets = this->textureAssets.size() + this->fontAssets.size();
+	Logger::Log("Loading " + std::to_string(numAssets) + " assets, " + std::to_string(textureAssets.size() + fontAssets.size() - numAssets) + " already resident");
+
+	if (numAssets == 0) {
+		decodesDone.set_value();
+		return acquired;
+	}
+
+	// each job only writes its own slot
+	for (size_t i = 0; i < this->textureAssets.size(); i++) {
+		threadPool.Enqueue([this, i]() {
+			const std::string& filePath = this->textureAssets[i].filePath;
+			const AssetPackEntry* entry = pack ? pack->Find(filePath, ASSET_PACK_IMAGE) : nullptr;
+			surfaces[i] = entry ? pack->CreateSurface(*entry) : IMG_Load(filePath.c_str());
+			if (!surfaces[i]) {
+				Logger::Err("Could not load texture " + this->textureAssets[i].filePath + ": " + IMG_GetError());
+			}
+			OnDecoded();
+		});
+	}
+	// FreeType is not thread safe, only the file read happens here
+	for (size_t i = 0; i < this->fontAssets.size(); i++) {
+		threadPool.Enqueue([this, i]() {
+			const AssetPackEntry* entry = pack ? pack->Find(this->fontAssets[i].filePath, ASSET_PACK_FONT) : nullptr;
+			if (entry) {
+				const uint8_t* bytes = nullptr;
+				size_t size = 0;
+				if (pack->GetBytes(*entry, bytes, size, fontData[i]) && fontData[i].empty()) {
+					fontViews[i] = bytes;
+					fontViewSizes[i] = size;
+				}
+				OnDecoded();
+				return;
+			}
+			std::ifstream file(this->fontAssets[i].filePath, std::ios::binary);
+			if (file) {
+				fontData[i].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			} else {
+				Logger::Err("Could not read font " + this->fontAssets[i].filePath);
+			}
+			OnDecoded();
+		});
+	}
+	return acquired;
+}
+
+float AssetLoader::GetProgress() const {
+	return numAssets > 0 ? static_cast<float>(numDecoded) / numAssets : 1.0f;
+}
+
+std::shared_future<void> AssetLoader::GetDecodesDone() const {
+	return decodesDoneFuture;
+}
+
+void AssetLoader::Upload(SDL_Renderer* renderer, AssetStore& assetStore, const std::string& layoutCacheDir) {
+	if (!isStarted) {
+		return;
+	}
+	decodesDoneFuture.wait();
+
+	// Packing needs every image size, so textures go up together as atlas pages
+	if (!textureAssets.empty()) {
+		assetStore.AddTextureAtlas(renderer, textureAssets, surfaces, layoutCacheDir);
+	}
+	surfaces.clear();
+
+	for (size_t i = 0; i < fontAssets.size(); i++) {
+		if (fontViews[i]) {
+			assetStore.AddFontFromView(fontAssets[i].assetId, fontViews[i], fontViewSizes[i], fontAssets[i].fontSize);
+		} else if (!fontData[i].empty()) {
+			assetStore.AddFontFromMemory(fontAssets[i].assetId, std::move(fontData[i]), fontAssets[i].fontSize);
+		}
+	}
+	fontData.clear();
+}
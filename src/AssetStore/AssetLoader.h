@@ -0,0 +1,58 @@
+#pragma once
+
+#include "AssetStore.h"
+#include "../ThreadPool/ThreadPool.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <future>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// AssetLoader
+////////////////////////////////////////////////////////////////////////////////
+// Loads a level's assets in two steps. Start acquires every asset and queues
+// one decode job per asset that is not already resident on the thread pool (images are decoded into
+// surfaces, font files are read into memory; assets in the store's pack are
+// used in place instead), then returns so the caller can
+// get on with the rest of the level. Upload waits for the decodes and turns
+// them into atlas pages and fonts; it needs the renderer, so it must run on
+// the render thread. Load time ends up bound by the slowest decode instead of
+// the sum of all of them.
+////////////////////////////////////////////////////////////////////////////////
+class AssetLoader {
+	private:
+		ThreadPool& threadPool;
+		const AssetPack* pack;
+
+		std::vector<TextureAssetInfo> textureAssets;
+		std::vector<SDL_Surface*> surfaces;
+		std::vector<FontAssetInfo> fontAssets;
+		std::vector<std::vector<char>> fontData;
+		std::vector<const uint8_t*> fontViews; // uncompressed fonts in the pack, used in place
+		std::vector<size_t> fontViewSizes;
+
+		size_t numAssets;
+		std::atomic<size_t> numDecoded;
+		std::promise<void> decodesDone;
+		std::shared_future<void> decodesDoneFuture;
+		bool isStarted;
+
+		void OnDecoded();
+
+	public:
+		AssetLoader(ThreadPool& threadPool);
+		~AssetLoader();
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+
+		// Returns the references taken, release them when the level goes away
+		LevelAssets Start(AssetStore& assetStore, const std::vector<TextureAssetInfo>& textureAssets, const std::vector<FontAssetInfo>& fontAssets);
+
+		// Fraction of assets decoded so far, 0..1
+		float GetProgress() const;
+		// Ready once every decode has finished
+		std::shared_future<void> GetDecodesDone() const;
+
+		void Upload(SDL_Renderer* renderer, AssetStore& assetStore, const std::string& layoutCacheDir);
+};
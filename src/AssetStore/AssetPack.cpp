@@ -0,0 +1,169 @@
+#include "AssetPack.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cstring>
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+AssetPack::AssetPack() {
+}
+
+AssetPack::~AssetPack() {
+	Close();
+}
+
+std::string AssetPack::NormalizePath(const std::string& assetPath) {
+	std::string path = assetPath;
+	for (auto& c: path) {
+		if (c == '\\') {
+			c = '/';
+		}
+	}
+	while (path.compare(0, 2, "./") == 0) {
+		path.erase(0, 2);
+	}
+	return path;
+}
+
+bool AssetPack::Open(const std::string& filePath) {
+	Close();
+	if (!file.Open(filePath)) {
+		return false;
+	}
+	const uint8_t* data = file.GetData();
+	const size_t dataSize = file.GetSize();
+
+	// Validate everything up front so lookups can trust the table
+	AssetPackHeader header;
+	if (dataSize < sizeof(header)) {
+		Logger::Err("Asset pack " + filePath + " is truncated");
+		Close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic)) != 0 || header.version != ASSET_PACK_VERSION) {
+		Logger::Err("Asset pack " + filePath + " has an unknown format");
+		Close();
+		return false;
+	}
+	if ((dataSize - sizeof(header)) / sizeof(AssetPackEntry) < header.numEntries) {
+		Logger::Err("Asset pack " + filePath + " table of contents is truncated");
+		Close();
+		return false;
+	}
+
+	const AssetPackEntry* table = reinterpret_cast<const AssetPackEntry*>(data + sizeof(header));
+	for (uint32_t i = 0; i < header.numEntries; i++) {
+		const AssetPackEntry& entry = table[i];
+		const bool hasName = std::memchr(entry.name, '\0', sizeof(entry.name)) != nullptr;
+		const bool isInFile = entry.offset <= dataSize && entry.storedSize <= dataSize - entry.offset;
+		uint64_t expectedSize = entry.size;
+		if (entry.type == ASSET_PACK_IMAGE) {
+			expectedSize = uint64_t(entry.width) * entry.height * 4;
+		} else if (entry.type == ASSET_PACK_TILEMAP) {
+			expectedSize = uint64_t(entry.width) * entry.height * sizeof(uint16_t);
+		}
+		const bool isCompressed = entry.flags & ASSET_PACK_LZ4;
+		if (!hasName || !isInFile || entry.size != expectedSize || (!isCompressed && entry.storedSize != entry.size)) {
+			Logger::Err("Asset pack " + filePath + " has a bad entry " + std::to_string(i));
+			Close();
+			return false;
+		}
+		entries.emplace(entry.name, &entry);
+	}
+
+	Logger::Log("Opened asset pack " + filePath + " with " + std::to_string(entries.size()) + " entries" + (file.IsMapped() ? " (mapped)" : ""));
+	return true;
+}
+
+void AssetPack::Close() {
+	file.Close();
+	entries.clear();
+}
+
+bool AssetPack::IsOpen() const {
+	return file.IsOpen();
+}
+
+size_t AssetPack::GetNumEntries() const {
+	return entries.size();
+}
+
+const AssetPackEntry* AssetPack::Find(const std::string& assetPath, AssetPackEntryType type) const {
+	auto entry = entries.find(NormalizePath(assetPath));
+	if (entry == entries.end() || entry->second->type != type) {
+		return nullptr;
+	}
+	return entry->second;
+}
+
+const uint8_t* AssetPack::GetBlock(const AssetPackEntry& entry) const {
+	return file.GetData() + entry.offset;
+}
+
+bool AssetPack::Unpack(const AssetPackEntry& entry, void* destination) const {
+	if (!(entry.flags & ASSET_PACK_LZ4)) {
+		std::memcpy(destination, GetBlock(entry), entry.size);
+		return true;
+	}
+#ifdef USE_LZ4
+	const int unpackedSize = LZ4_decompress_safe(
+		reinterpret_cast<const char*>(GetBlock(entry)), static_cast<char*>(destination),
+		static_cast<int>(entry.storedSize), static_cast<int>(entry.size)
+	);
+	if (unpackedSize == static_cast<int>(entry.size)) {
+		return true;
+	}
+	Logger::Err(std::string("Corrupt compressed asset ") + entry.name);
+#else
+	Logger::Err(std::string("Asset ") + entry.name + " is LZ4 compressed, rebuild with LZ4=1");
+#endif
+	return false;
+}
+
+SDL_Surface* AssetPack::CreateSurface(const AssetPackEntry& entry) const {
+	if (entry.type != ASSET_PACK_IMAGE) {
+		return nullptr;
+	}
+	if (!(entry.flags & ASSET_PACK_LZ4)) {
+		// no copy, SDL only reads from source surfaces
+		return SDL_CreateRGBSurfaceWithFormatFrom(
+			const_cast<uint8_t*>(GetBlock(entry)), entry.width, entry.height, 32, entry.width * 4, SDL_PIXELFORMAT_RGBA32
+		);
+	}
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, entry.width, entry.height, 32, SDL_PIXELFORMAT_RGBA32);
+	if (surface && (surface->pitch != static_cast<int>(entry.width * 4) || !Unpack(entry, surface->pixels))) {
+		SDL_FreeSurface(surface);
+		return nullptr;
+	}
+	return surface;
+}
+
+bool AssetPack::GetBytes(const AssetPackEntry& entry, const uint8_t*& bytes, size_t& size, std::vector<char>& buffer) const {
+	size = entry.size;
+	if (!(entry.flags & ASSET_PACK_LZ4)) {
+		bytes = GetBlock(entry);
+		return true;
+	}
+	buffer.resize(entry.size);
+	bytes = reinterpret_cast<const uint8_t*>(buffer.data());
+	return Unpack(entry, buffer.data());
+}
+
+bool AssetPack::ReadTileMap(const AssetPackEntry& entry, int numRows, int numCols, std::vector<uint16_t>& tiles) const {
+	if (entry.type != ASSET_PACK_TILEMAP) {
+		return false;
+	}
+	std::vector<uint16_t> packedTiles(entry.width * entry.height);
+	if (!Unpack(entry, packedTiles.data())) {
+		return false;
+	}
+	tiles.assign(numRows * numCols, 0);
+	const int rows = std::min<int>(numRows, entry.height);
+	const int cols = std::min<int>(numCols, entry.width);
+	for (int row = 0; row < rows; row++) {
+		std::copy(packedTiles.begin() + row * entry.width, packedTiles.begin() + row * entry.width + cols, tiles.begin() + row * numCols);
+	}
+	return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Asset pack file layout (little endian)
+////////////////////////////////////////////////////////////////////////////////
+//   AssetPackHeader
+//   AssetPackEntry[numEntries]     table of contents, sorted by name
+//   data blocks                    each starts on a 16 byte boundary
+//
+// Images are stored decoded as RGBA32 rows without padding, tilemaps as
+// row-major uint16 tile indices, fonts as the original font file. Any block
+// may be LZ4 compressed when the pack tool was built with LZ4.
+// Entries are named by their asset path without a leading "./", eg
+// "assets/images/tank-panther-right.png".
+////////////////////////////////////////////////////////////////////////////////
+const char ASSET_PACK_MAGIC[4] = { 'A', 'P', 'A', 'K' };
+const uint32_t ASSET_PACK_VERSION = 1;
+const size_t ASSET_PACK_ALIGNMENT = 16;
+const size_t ASSET_PACK_MAX_NAME = 112;
+
+enum AssetPackEntryType: uint32_t {
+	ASSET_PACK_IMAGE = 1,
+	ASSET_PACK_FONT = 2,
+	ASSET_PACK_TILEMAP = 3
+};
+
+enum AssetPackEntryFlags: uint32_t {
+	ASSET_PACK_LZ4 = 1
+};
+
+struct AssetPackHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t reserved;
+};
+
+struct AssetPackEntry {
+	char name[ASSET_PACK_MAX_NAME];	// nul terminated
+	uint32_t type;
+	uint32_t flags;
+	uint32_t width;		// pixels for images, columns for tilemaps
+	uint32_t height;	// pixels for images, rows for tilemaps
+	uint64_t offset;	// from the start of the file
+	uint64_t storedSize;	// bytes in the file
+	uint64_t size;		// bytes once uncompressed
+};
+
+static_assert(sizeof(AssetPackHeader) == 16, "asset pack header layout changed");
+static_assert(sizeof(AssetPackEntry) == 152, "asset pack entry layout changed");
+
+////////////////////////////////////////////////////////////////////////////////
+// AssetPack
+////////////////////////////////////////////////////////////////////////////////
+// Read side of an asset pack. The file is memory mapped and never copied as a
+// whole; uncompressed images become surfaces that point straight into the
+// mapping and fonts are opened from it in place. Safe to read from several
+// threads once open.
+////////////////////////////////////////////////////////////////////////////////
+class AssetPack {
+	private:
+		MappedFile file;
+
+		std::unordered_map<std::string, const AssetPackEntry*> entries;
+
+		const uint8_t* GetBlock(const AssetPackEntry& entry) const;
+		bool Unpack(const AssetPackEntry& entry, void* destination) const;
+
+	public:
+		AssetPack();
+		~AssetPack();
+		AssetPack(const AssetPack&) = delete;
+		AssetPack& operator=(const AssetPack&) = delete;
+
+		bool Open(const std::string& filePath);
+		void Close();
+		bool IsOpen() const;
+		size_t GetNumEntries() const;
+
+		// Looks up the entry for an asset path, null if it is not packed as that type
+		const AssetPackEntry* Find(const std::string& assetPath, AssetPackEntryType type) const;
+
+		// RGBA32 surface of a packed image, free it with SDL_FreeSurface. Only
+		// valid while the pack is open when the image was stored uncompressed
+		SDL_Surface* CreateSurface(const AssetPackEntry& entry) const;
+
+		// Bytes of an uncompressed block in place, or unpacked into buffer
+		bool GetBytes(const AssetPackEntry& entry, const uint8_t*& bytes, size_t& size, std::vector<char>& buffer) const;
+
+		// Copies a packed tile grid into a numRows x numCols grid, extra tiles are dropped
+		bool ReadTileMap(const AssetPackEntry& entry, int numRows, int numCols, std::vector<uint16_t>& tiles) const;
+
+		static std::string NormalizePath(const std::string& assetPath);
+};
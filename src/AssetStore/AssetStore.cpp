@@ -1,9 +1,47 @@
 #include "./AssetStore.h"
+#include "./TexturePacker.h"
 #include "../Logger/Logger.h"
-#include "SDL2/SDL_image.h"
 #include "SDL2/SDL_ttf.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+	size_t GetTextureBytes(SDL_Texture* texture) {
+		int width = 0;
+		int height = 0;
+		if (!texture || SDL_QueryTexture(texture, NULL, NULL, &width, &height) != 0) {
+			return 0;
+		}
+		return size_t(width) * height * 4;
+	}
+
+	std::string GetFontSource(const std::string& filePath, int fontSize) {
+		return filePath + "@" + std::to_string(fontSize);
+	}
+
+	uint32_t NextGeneration(uint32_t generation) {
+		return (generation + 1) & TextureHandle::GENERATION_MASK;
+	}
+}
 
 AssetStore::AssetStore() {
+	// slot 0 is never handed out
+	textureRegions.assign(1, { nullptr, { 0, 0, 0, 0 } });
+	textureResidency.resize(1);
+	fonts.assign(1, nullptr);
+	fontData.resize(1);
+	glyphAtlases.resize(1);
+	isGlyphAtlasBuilt.assign(1, true);
+	fontResidency.resize(1);
+	textureBudget = DEFAULT_TEXTURE_BUDGET;
+	textureBytes = 0;
+	useClock = 0;
+	hits = 0;
+	misses = 0;
+	evictions = 0;
 	Logger::Log("AssetStore constructor called.");
 }
 
@@ -13,34 +51,495 @@ AssetStore::~AssetStore() {
 }
 
 void AssetStore::ClearAssets() {
-	for (auto texture: textures) {
-		SDL_DestroyTexture(texture.second); // dealloc textures in memory
+	for (auto& owned: ownedTextures) {
+		SDL_DestroyTexture(owned.first); // dealloc textures in memory
 	}
-	textures.clear(); // only clears memory
+	ownedTextures.clear();
 	for (auto font: fonts) {
-		TTF_CloseFont(font.second); // dealloc textures in memory
+		if (font) {
+			TTF_CloseFont(font); // dealloc textures in memory
+		}
+	}
+	textureHandles.clear();
+	fontHandles.clear();
+	textureBytes = 0;
+
+	// every slot goes back on the free list, and stops resolving handles handed out so far
+	freeTextureSlots.clear();
+	for (uint32_t index = textureRegions.size() - 1; index > 0; index--) {
+		textureRegions[index] = { nullptr, { 0, 0, 0, 0 } };
+		textureResidency[index] = { "", "", 0, 0, NextGeneration(textureResidency[index].generation) };
+		freeTextureSlots.push_back(index);
+	}
+	freeFontSlots.clear();
+	for (uint32_t index = fonts.size() - 1; index > 0; index--) {
+		fonts[index] = nullptr;
+		fontData[index].clear();
+		glyphAtlases[index].reset();
+		isGlyphAtlasBuilt[index] = false;
+		fontResidency[index] = { "", "", 0, 0, NextGeneration(fontResidency[index].generation) };
+		freeFontSlots.push_back(index);
+	}
+}
+
+uint32_t AssetStore::AllocateTextureSlot() {
+	if (!freeTextureSlots.empty()) {
+		const uint32_t index = freeTextureSlots.back();
+		freeTextureSlots.pop_back();
+		return index;
+	}
+	textureRegions.push_back({ nullptr, { 0, 0, 0, 0 } });
+	textureResidency.emplace_back();
+	return textureRegions.size() - 1;
+}
+
+uint32_t AssetStore::AllocateFontSlot() {
+	if (!freeFontSlots.empty()) {
+		const uint32_t index = freeFontSlots.back();
+		freeFontSlots.pop_back();
+		return index;
+	}
+	fonts.push_back(nullptr);
+	fontData.emplace_back();
+	glyphAtlases.emplace_back();
+	isGlyphAtlasBuilt.push_back(false);
+	fontResidency.emplace_back();
+	return fonts.size() - 1;
+}
+
+void AssetStore::FreeTextureSlot(uint32_t index) {
+	AssetResidency& residency = textureResidency[index];
+	auto handle = textureHandles.find(residency.assetId);
+	if (handle != textureHandles.end() && handle->second.GetIndex() == index) {
+		textureHandles.erase(handle);
+	}
+	textureRegions[index] = { nullptr, { 0, 0, 0, 0 } };
+	residency = { "", "", 0, 0, NextGeneration(residency.generation) };
+	freeTextureSlots.push_back(index);
+}
+
+void AssetStore::FreeFontSlot(uint32_t index) {
+	AssetResidency& residency = fontResidency[index];
+	auto handle = fontHandles.find(residency.assetId);
+	if (handle != fontHandles.end() && handle->second.GetIndex() == index) {
+		fontHandles.erase(handle);
+	}
+	fonts[index] = nullptr;
+	fontData[index].clear();
+	glyphAtlases[index].reset();
+	isGlyphAtlasBuilt[index] = false;
+	residency = { "", "", 0, 0, NextGeneration(residency.generation) };
+	freeFontSlots.push_back(index);
+}
+
+TextureHandle AssetStore::ReserveTexture(const std::string& assetId, const std::string& source) {
+	auto existing = textureHandles.find(assetId);
+	if (existing != textureHandles.end()) {
+		const uint32_t index = existing->second.GetIndex();
+		if (source.empty() || textureResidency[index].source.empty() || textureResidency[index].source == source) {
+			if (textureResidency[index].source.empty()) {
+				textureResidency[index].source = source;
+			}
+			return existing->second;
+		}
+		// Same id from another file: whoever holds the old one keeps it, but it is no longer found by id
+		Logger::Log("Texture id = " + assetId + " now loads from " + source);
+		textureResidency[index].assetId.clear();
+		textureHandles.erase(existing);
+	}
+	const uint32_t index = AllocateTextureSlot();
+	textureResidency[index].assetId = assetId;
+	textureResidency[index].source = source;
+	TextureHandle handle(index, textureResidency[index].generation);
+	textureHandles.emplace(assetId, handle);
+	return handle;
+}
+
+FontHandle AssetStore::ReserveFont(const std::string& assetId, const std::string& source) {
+	auto existing = fontHandles.find(assetId);
+	if (existing != fontHandles.end()) {
+		const uint32_t index = existing->second.GetIndex();
+		if (source.empty() || fontResidency[index].source.empty() || fontResidency[index].source == source) {
+			if (fontResidency[index].source.empty()) {
+				fontResidency[index].source = source;
+			}
+			return existing->second;
+		}
+		Logger::Log("Font id = " + assetId + " now loads from " + source);
+		fontResidency[index].assetId.clear();
+		fontHandles.erase(existing);
 	}
-	fonts.clear();
+	const uint32_t index = AllocateFontSlot();
+	fontResidency[index].assetId = assetId;
+	fontResidency[index].source = source;
+	FontHandle handle(index, fontResidency[index].generation);
+	fontHandles.emplace(assetId, handle);
+	return handle;
 }
 
-void AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath) {
-	SDL_Surface* surface = IMG_Load(filePath.c_str());
-	SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-	SDL_FreeSurface(surface);
+TextureHandle AssetStore::AcquireTexture(const TextureAssetInfo& asset) {
+	TextureHandle handle = ReserveTexture(asset.assetId, asset.filePath);
+	textureResidency[handle.GetIndex()].refCount++;
+	if (IsTextureLoaded(handle)) {
+		hits++;
+	} else {
+		misses++;
+	}
+	return handle;
+}
+
+FontHandle AssetStore::AcquireFont(const FontAssetInfo& asset) {
+	FontHandle handle = ReserveFont(asset.assetId, GetFontSource(asset.filePath, asset.fontSize));
+	fontResidency[handle.GetIndex()].refCount++;
+	if (IsFontLoaded(handle)) {
+		hits++;
+	} else {
+		misses++;
+	}
+	return handle;
+}
+
+void AssetStore::ReleaseTexture(TextureHandle handle) {
+	const uint32_t index = handle.GetIndex();
+	if (index == 0 || index >= textureResidency.size() || handle.GetGeneration() != textureResidency[index].generation) {
+		return; // already evicted or cleared
+	}
+	AssetResidency& residency = textureResidency[index];
+	if (residency.refCount > 0 && --residency.refCount == 0) {
+		residency.lastUsed = ++useClock;
+	}
+}
+
+void AssetStore::ReleaseFont(FontHandle handle) {
+	const uint32_t index = handle.GetIndex();
+	if (index == 0 || index >= fontResidency.size() || handle.GetGeneration() != fontResidency[index].generation) {
+		return;
+	}
+	AssetResidency& residency = fontResidency[index];
+	if (residency.refCount > 0 && --residency.refCount == 0) {
+		residency.lastUsed = ++useClock;
+	}
+}
+
+void AssetStore::Release(const LevelAssets& levelAssets) {
+	for (auto handle: levelAssets.textures) {
+		ReleaseTexture(handle);
+	}
+	for (auto handle: levelAssets.fonts) {
+		ReleaseFont(handle);
+	}
+}
+
+bool AssetStore::IsTextureLoaded(TextureHandle handle) const {
+	return GetTexture(handle) != nullptr;
+}
+
+bool AssetStore::IsFontLoaded(FontHandle handle) const {
+	return GetFont(handle) != nullptr;
+}
 
-	// add texture to map
-	textures.emplace(assetId, texture);
+void AssetStore::Trim() {
+	while (textureBytes > textureBudget) {
+		// Oldest unreferenced texture or font; a texture counts as used as
+		// recently as the newest region on it
+		SDL_Texture* oldestTexture = nullptr;
+		uint32_t oldestFont = 0;
+		uint64_t oldest = UINT64_MAX;
+		for (const auto& owned: ownedTextures) {
+			bool isReferenced = false;
+			uint64_t lastUsed = 0;
+			for (auto index: owned.second.regions) {
+				isReferenced = isReferenced || textureResidency[index].refCount > 0;
+				lastUsed = std::max(lastUsed, textureResidency[index].lastUsed);
+			}
+			if (!isReferenced && lastUsed < oldest) {
+				oldest = lastUsed;
+				oldestTexture = owned.first;
+			}
+		}
+		for (uint32_t index = 1; index < fonts.size(); index++) {
+			if (fonts[index] && fontResidency[index].refCount == 0 && fontResidency[index].lastUsed < oldest) {
+				oldest = fontResidency[index].lastUsed;
+				oldestTexture = nullptr;
+				oldestFont = index;
+			}
+		}
 
-	Logger::Log("Added texture id = " + assetId + " " + filePath);
+		if (oldestFont) {
+			EvictFont(oldestFont);
+		} else if (oldestTexture) {
+			EvictTexture(oldestTexture);
+		} else {
+			Logger::Err("Referenced textures need " + std::to_string(textureBytes / (1024 * 1024)) + " MB, over the " + std::to_string(textureBudget / (1024 * 1024)) + " MB budget");
+			break;
+		}
+	}
 }
 
-SDL_Texture* AssetStore::GetTexture(const std::string& assetId) {
-	return textures[assetId];
+void AssetStore::EvictTexture(SDL_Texture* texture) {
+	auto owned = ownedTextures.find(texture);
+	if (owned == ownedTextures.end()) {
+		return;
+	}
+	for (auto index: owned->second.regions) {
+		FreeTextureSlot(index);
+	}
+	textureBytes -= owned->second.bytes;
+	ownedTextures.erase(owned);
+	SDL_DestroyTexture(texture);
+	evictions++;
 }
-void AssetStore::AddFont(const std::string& assetId, const std::string& filePath, int fontSize) {
-	fonts.emplace(assetId, TTF_OpenFont(filePath.c_str(), fontSize));
-	Logger::Log("Added font id = " + assetId + " " + filePath);
+
+void AssetStore::EvictFont(uint32_t index) {
+	if (glyphAtlases[index]) {
+		textureBytes -= GetTextureBytes(glyphAtlases[index]->GetTexture());
+	}
+	TTF_CloseFont(fonts[index]);
+	Logger::Log("Evicted font id = " + fontResidency[index].assetId);
+	FreeFontSlot(index);
+	evictions++;
+}
+
+void AssetStore::SetTextureBudget(size_t bytes) {
+	textureBudget = bytes;
+}
+
+AssetCacheStats AssetStore::GetCacheStats() const {
+	AssetCacheStats stats = { hits, misses, evictions, textureBytes, textureBudget, 0, 0 };
+	for (uint32_t index = 1; index < textureRegions.size(); index++) {
+		stats.numTextures += textureRegions[index].texture != nullptr;
+	}
+	for (uint32_t index = 1; index < fonts.size(); index++) {
+		stats.numFonts += fonts[index] != nullptr;
+	}
+	return stats;
+}
+
+void AssetStore::AddOwnedTexture(SDL_Texture* texture, size_t bytes) {
+	ownedTextures[texture].bytes = bytes;
+	textureBytes += bytes;
+}
+
+void AssetStore::SetTextureRegion(TextureHandle handle, const TextureRegion& region) {
+	const uint32_t index = handle.GetIndex();
+	TextureRegion& slot = textureRegions[index];
+	if (slot.texture) {
+		Logger::Err("Texture id = " + textureResidency[index].assetId + " already loaded, keeping the first one");
+		return;
+	}
+	slot = region;
+	auto owned = ownedTextures.find(region.texture);
+	if (owned != ownedTextures.end()) {
+		owned->second.regions.push_back(index);
+	}
+}
+
+bool AssetStore::OpenPack(const std::string& filePath) {
+	auto newPack = std::make_unique<AssetPack>();
+	if (!newPack->Open(filePath)) {
+		Logger::Log("No asset pack at " + filePath + ", loading loose files");
+		return false;
+	}
+	pack = std::move(newPack);
+	return true;
+}
+
+const AssetPack* AssetStore::GetPack() const {
+	return pack.get();
+}
+
+namespace {
+	// Layout only depends on which images go in and how big they are
+	uint64_t HashAtlasInputs(const std::vector<TextureAssetInfo>& textureAssets, const std::vector<SDL_Point>& sizes) {
+		uint64_t hash = 14695981039346656037ull; // FNV-1a
+		auto mix = [&hash](const std::string& value) {
+			for (char c: value) {
+				hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+			}
+		};
+		for (size_t i = 0; i < textureAssets.size(); i++) {
+			mix(textureAssets[i].assetId + "|" + textureAssets[i].filePath + "|" + std::to_string(sizes[i].x) + "x" + std::to_string(sizes[i].y) + ";");
+		}
+		mix("page" + std::to_string(AssetStore::ATLAS_PAGE_SIZE));
+		return hash;
+	}
+
+	bool ReadAtlasLayout(const std::string& path, uint64_t hash, size_t numTextures, std::vector<TexturePacker::Placement>& placements, int& numPages) {
+		std::ifstream file(path);
+		std::string magic;
+		uint64_t fileHash = 0;
+		size_t fileNumTextures = 0;
+		if (!(file >> magic >> std::hex >> fileHash >> std::dec >> numPages >> fileNumTextures)) {
+			return false;
+		}
+		if (magic != "atlas1" || fileHash != hash || fileNumTextures != numTextures) {
+			return false;
+		}
+		placements.resize(numTextures);
+		for (auto& placement: placements) {
+			if (!(file >> placement.page >> placement.x >> placement.y) || placement.page >= numPages) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void WriteAtlasLayout(const std::string& path, uint64_t hash, const std::vector<TexturePacker::Placement>& placements, int numPages) {
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+		std::ofstream file(path);
+		if (!file) {
+			Logger::Err("Could not write atlas layout cache " + path);
+			return;
+		}
+		file << "atlas1 " << std::hex << hash << std::dec << " " << numPages << " " << placements.size() << "\n";
+		for (const auto& placement: placements) {
+			file << placement.page << " " << placement.x << " " << placement.y << "\n";
+		}
+	}
+}
+
+void AssetStore::AddTextureAtlas(SDL_Renderer* renderer, const std::vector<TextureAssetInfo>& textureAssets, const std::vector<SDL_Surface*>& surfaces, const std::string& layoutCacheDir) {
+	std::vector<SDL_Point> sizes;
+	for (auto surface: surfaces) {
+		sizes.push_back(surface ? SDL_Point{ surface->w, surface->h } : SDL_Point{ 0, 0 });
+	}
+
+	// Reuse the cached layout when the inputs match, otherwise pack and cache it.
+	// One file per input set, so levels loaded in a different order don't
+	// overwrite each other's layouts
+	const uint64_t hash = HashAtlasInputs(textureAssets, sizes);
+	char hashName[32];
+	std::snprintf(hashName, sizeof(hashName), "%016llx.atlas", static_cast<unsigned long long>(hash));
+	const std::string layoutCachePath = layoutCacheDir + "/" + hashName;
+	std::vector<TexturePacker::Placement> placements;
+	int numPages = 0;
+	if (ReadAtlasLayout(layoutCachePath, hash, textureAssets.size(), placements, numPages)) {
+		Logger::Log("Using cached atlas layout " + layoutCachePath);
+	} else {
+		TexturePacker packer(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+		placements = packer.Pack(sizes);
+		numPages = packer.GetNumPages();
+		WriteAtlasLayout(layoutCachePath, hash, placements, numPages);
+	}
+
+	// Compose the pages in memory, then upload each page once
+	std::vector<SDL_Surface*> pageSurfaces(numPages, nullptr);
+	for (auto& pageSurface: pageSurfaces) {
+		pageSurface = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+	}
+	for (size_t i = 0; i < textureAssets.size(); i++) {
+		const auto& placement = placements[i];
+		if (!surfaces[i] || placement.page < 0 || !pageSurfaces[placement.page]) {
+			continue;
+		}
+		SDL_Rect rect = { placement.x, placement.y, sizes[i].x, sizes[i].y };
+		SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+		SDL_BlitSurface(surfaces[i], NULL, pageSurfaces[placement.page], &rect);
+	}
+
+	std::vector<SDL_Texture*> pageTextures(numPages, nullptr);
+	for (int page = 0; page < numPages; page++) {
+		if (pageSurfaces[page]) {
+			pageTextures[page] = SDL_CreateTextureFromSurface(renderer, pageSurfaces[page]);
+			SDL_FreeSurface(pageSurfaces[page]);
+		}
+		if (pageTextures[page]) {
+			SDL_SetTextureBlendMode(pageTextures[page], SDL_BLENDMODE_BLEND);
+			AddOwnedTexture(pageTextures[page], size_t(ATLAS_PAGE_SIZE) * ATLAS_PAGE_SIZE * 4);
+		}
+	}
+
+	for (size_t i = 0; i < textureAssets.size(); i++) {
+		const auto& asset = textureAssets[i];
+		const auto& placement = placements[i];
+		TextureRegion region;
+		if (placement.page >= 0 && pageTextures[placement.page]) {
+			region = { pageTextures[placement.page], { placement.x, placement.y, sizes[i].x, sizes[i].y } };
+		} else {
+			// too big for a page (or the page failed), keep it as its own texture
+			region = { surfaces[i] ? SDL_CreateTextureFromSurface(renderer, surfaces[i]) : nullptr, { 0, 0, sizes[i].x, sizes[i].y } };
+			if (region.texture) {
+				AddOwnedTexture(region.texture, size_t(sizes[i].x) * sizes[i].y * 4);
+			}
+		}
+		SetTextureRegion(ReserveTexture(asset.assetId, asset.filePath), region);
+		SDL_FreeSurface(surfaces[i]);
+	}
+
+	Logger::Log("Packed " + std::to_string(textureAssets.size()) + " textures into " + std::to_string(numPages) + " atlas pages");
+}
+
+TextureHandle AssetStore::GetTextureHandle(const std::string& assetId) const {
+	auto handle = textureHandles.find(assetId);
+	if (handle == textureHandles.end()) {
+		Logger::Err("Unknown texture id = " + assetId);
+		return TextureHandle();
+	}
+	return handle->second;
+}
+
+FontHandle AssetStore::AddFontFromMemory(const std::string& assetId, std::vector<char> data, int fontSize) {
+	FontHandle handle = ReserveFont(assetId, "");
+	const uint32_t index = handle.GetIndex();
+	if (fonts[index]) {
+		Logger::Err("Font id = " + assetId + " already loaded, keeping the first one");
+		return handle;
+	}
+	// SDL_ttf reads from the buffer for as long as the font is open, the store keeps it
+	fontData[index] = std::move(data);
+	return AddFontFromView(assetId, fontData[index].data(), fontData[index].size(), fontSize);
+}
+
+FontHandle AssetStore::AddFontFromView(const std::string& assetId, const void* bytes, size_t size, int fontSize) {
+	FontHandle handle = ReserveFont(assetId, "");
+	const uint32_t index = handle.GetIndex();
+	if (fonts[index]) {
+		Logger::Err("Font id = " + assetId + " already loaded, keeping the first one");
+		return handle;
+	}
+	SDL_RWops* rw = SDL_RWFromConstMem(bytes, size);
+	TTF_Font* font = rw ? TTF_OpenFontRW(rw, 1, fontSize) : nullptr;
+	if (!font) {
+		Logger::Err("Could not load font id = " + assetId + ": " + TTF_GetError());
+	}
+	fonts[index] = font;
+	Logger::Log("Added font id = " + assetId);
+	return handle;
+}
+
+FontHandle AssetStore::GetFontHandle(const std::string& assetId) const {
+	auto handle = fontHandles.find(assetId);
+	if (handle == fontHandles.end()) {
+		Logger::Err("Unknown font id = " + assetId);
+		return FontHandle();
+	}
+	return handle->second;
+}
+
+TTF_Font* AssetStore::GetFont(FontHandle handle) const {
+	const uint32_t index = handle.GetIndex();
+	if (index >= fonts.size() || handle.GetGeneration() != fontResidency[index].generation) {
+		return nullptr;
+	}
+	return fonts[index];
+}
+
+const GlyphAtlas* AssetStore::GetGlyphAtlas(SDL_Renderer* renderer, FontHandle handle) {
+	TTF_Font* font = GetFont(handle);
+	if (!font) {
+		return nullptr;
+	}
+	const uint32_t index = handle.GetIndex();
+	if (!isGlyphAtlasBuilt[index]) {
+		// a failed build is remembered too, instead of retrying every frame
+		isGlyphAtlasBuilt[index] = true;
+		auto atlas = std::make_unique<GlyphAtlas>();
+		if (atlas->Build(renderer, font)) {
+			textureBytes += GetTextureBytes(atlas->GetTexture());
+			glyphAtlases[index] = std::move(atlas);
+			Logger::Log("Built glyph atlas for font " + std::to_string(index));
+		}
+	}
+	return glyphAtlases[index].get();
 }
-TTF_Font* AssetStore::GetFont(const std::string& assetId) {
-	return fonts[assetId];
-}
\ No newline at end of file
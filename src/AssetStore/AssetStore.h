@@ -1,24 +1,166 @@
 #pragma once
 
-#include <map>
+#include "AssetHandle.h"
+#include "AssetPack.h"
+#include "GlyphAtlas.h"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
+// Where a texture asset lives: its own texture, or a rect inside an atlas page
+struct TextureRegion {
+	SDL_Texture* texture;
+	SDL_Rect rect;
+};
+
+// A texture asset to be packed, as listed in a level's assets table
+struct TextureAssetInfo {
+	std::string assetId;
+	std::string filePath;
+};
+
+struct FontAssetInfo {
+	std::string assetId;
+	std::string filePath;
+	int fontSize;
+};
+
+// The references a loaded level holds, given back when the level goes away
+struct LevelAssets {
+	std::vector<TextureHandle> textures;
+	std::vector<FontHandle> fonts;
+};
+
+// Cache bookkeeping for one texture or font slot
+struct AssetResidency {
+	std::string assetId;
+	std::string source;	// file (and font size) it was loaded from, a later load must match to reuse it
+	int refCount = 0;
+	uint64_t lastUsed = 0;	// when the last reference went, unreferenced assets go oldest first
+	uint32_t generation = 0;
+};
+
+struct AssetCacheStats {
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t textureBytes;	// atlas pages, standalone textures and glyph atlases
+	size_t textureBudget;
+	size_t numTextures;
+	size_t numFonts;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// AssetStore
+////////////////////////////////////////////////////////////////////////////////
+// Levels acquire the assets they list and release them when they unload.
+// Released assets stay resident, so the next level gets the ones it shares
+// with the last one for free, until the texture memory goes over budget; then
+// Trim evicts unreferenced assets least recently used first. Textures packed
+// into the same atlas page can only go together, once none of them is used.
+////////////////////////////////////////////////////////////////////////////////
 class AssetStore {
 	private:
-		std::map<std::string, SDL_Texture*> textures;
-		std::map<std::string, TTF_Font*> fonts;
-		// todo map for audio
+		// A texture the store created (atlas page or standalone) and the texture slots pointing into it
+		struct OwnedTexture {
+			size_t bytes;
+			std::vector<uint32_t> regions;
+		};
+
+		// Slot 0 of each array stands in for missing assets [index = handle index]
+		std::vector<TextureRegion> textureRegions;
+		std::vector<AssetResidency> textureResidency;
+		std::vector<uint32_t> freeTextureSlots;
+		std::vector<TTF_Font*> fonts;
+		std::vector<std::vector<char>> fontData; // file contents of fonts opened from memory
+		std::vector<std::unique_ptr<GlyphAtlas>> glyphAtlases; // built on first use per font
+		std::vector<bool> isGlyphAtlasBuilt;
+		std::vector<AssetResidency> fontResidency;
+		std::vector<uint32_t> freeFontSlots;
+		// todo audio
+
+		// String ids are only for the loader and Lua side
+		std::unordered_map<std::string, TextureHandle> textureHandles;
+		std::unordered_map<std::string, FontHandle> fontHandles;
+
+		std::unordered_map<SDL_Texture*, OwnedTexture> ownedTextures;
+		std::unique_ptr<AssetPack> pack; // outlives ClearAssets, fonts may point into it
+
+		size_t textureBudget;
+		size_t textureBytes;
+		uint64_t useClock;
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+
+		TextureHandle ReserveTexture(const std::string& assetId, const std::string& source);
+		FontHandle ReserveFont(const std::string& assetId, const std::string& source);
+		uint32_t AllocateTextureSlot();
+		uint32_t AllocateFontSlot();
+		void FreeTextureSlot(uint32_t index);
+		void FreeFontSlot(uint32_t index);
+		void AddOwnedTexture(SDL_Texture* texture, size_t bytes);
+		void SetTextureRegion(TextureHandle handle, const TextureRegion& region);
+		void EvictTexture(SDL_Texture* texture);
+		void EvictFont(uint32_t index);
 
 	public:
+		// Atlas pages are kept at a size every renderer supports
+		static const int ATLAS_PAGE_SIZE = 2048;
+		static const size_t DEFAULT_TEXTURE_BUDGET = 256 * 1024 * 1024;
+
 		AssetStore();
 		~AssetStore();
 
+		// Drops everything, referenced or not
 		void ClearAssets();
-		void AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath);
-		SDL_Texture* GetTexture(const std::string& assetId);
 
-		void AddFont(const std::string& assetId, const std::string& filePath, int fontSize);
-		TTF_Font* GetFont(const std::string& assetId);
-};
\ No newline at end of file
+		// Pre-decoded assets are taken from the pack when it has them, loose files otherwise
+		bool OpenPack(const std::string& filePath);
+		const AssetPack* GetPack() const;
+
+		// Takes a reference on an asset, reserving its handle if it is not
+		// resident. The handle resolves to an empty region / no font until the
+		// asset is added, IsTextureLoaded / IsFontLoaded tell which it was.
+		TextureHandle AcquireTexture(const TextureAssetInfo& asset);
+		FontHandle AcquireFont(const FontAssetInfo& asset);
+		void ReleaseTexture(TextureHandle handle);
+		void ReleaseFont(FontHandle handle);
+		void Release(const LevelAssets& levelAssets);
+		bool IsTextureLoaded(TextureHandle handle) const;
+		bool IsFontLoaded(FontHandle handle) const;
+
+		// Evicts unreferenced assets until the textures fit the budget. Destroys
+		// textures, so it runs where the renderer lives.
+		void Trim();
+		void SetTextureBudget(size_t bytes);
+		AssetCacheStats GetCacheStats() const;
+
+		// Packs already decoded images (one per asset, may be null) into atlas
+		// pages and frees them. Layouts are cached in layoutCacheDir under the
+		// hash of what went in, which depends on what was already resident
+		void AddTextureAtlas(SDL_Renderer* renderer, const std::vector<TextureAssetInfo>& textureAssets, const std::vector<SDL_Surface*>& surfaces, const std::string& layoutCacheDir);
+		TextureHandle GetTextureHandle(const std::string& assetId) const;
+
+		const TextureRegion& GetTextureRegion(TextureHandle handle) const {
+			const uint32_t index = handle.GetIndex();
+			if (index >= textureRegions.size() || handle.GetGeneration() != textureResidency[index].generation) {
+				return textureRegions[0];
+			}
+			return textureRegions[index];
+		}
+		SDL_Texture* GetTexture(TextureHandle handle) const {
+			return GetTextureRegion(handle).texture;
+		}
+
+		FontHandle AddFontFromMemory(const std::string& assetId, std::vector<char> data, int fontSize);
+		// bytes are not copied, they must stay valid while the font is loaded (eg the mapped pack)
+		FontHandle AddFontFromView(const std::string& assetId, const void* bytes, size_t size, int fontSize);
+		FontHandle GetFontHandle(const std::string& assetId) const;
+		TTF_Font* GetFont(FontHandle handle) const;
+		const GlyphAtlas* GetGlyphAtlas(SDL_Renderer* renderer, FontHandle handle);
+};
@@ -0,0 +1,102 @@
+#include "GlyphAtlas.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+
+uint32_t GlyphAtlas::nextId = 1;
+
+GlyphAtlas::GlyphAtlas() {
+	texture = nullptr;
+	lineHeight = 0;
+	id = 0;
+	for (auto& glyph: glyphs) {
+		glyph = { { 0, 0, 0, 0 }, 0 };
+	}
+}
+
+GlyphAtlas::~GlyphAtlas() {
+	if (texture) {
+		SDL_DestroyTexture(texture);
+	}
+}
+
+bool GlyphAtlas::Build(SDL_Renderer* renderer, TTF_Font* font) {
+	if (!font) {
+		return false;
+	}
+	const int numGlyphs = LAST_GLYPH - FIRST_GLYPH + 1;
+	const int atlasWidth = 512;
+	const int padding = 1;
+	SDL_Color white = { 255, 255, 255, 255 };
+
+	// Rasterize every glyph and shelf pack the cells row by row
+	SDL_Surface* glyphSurfaces[numGlyphs] = {};
+	int penX = 0;
+	int penY = 0;
+	int rowHeight = 0;
+	for (int i = 0; i < numGlyphs; i++) {
+		Uint16 character = FIRST_GLYPH + i;
+		int advance = 0;
+		TTF_GlyphMetrics(font, character, NULL, NULL, NULL, NULL, &advance);
+		glyphs[i].advance = advance;
+
+		glyphSurfaces[i] = TTF_RenderGlyph_Blended(font, character, white);
+		if (!glyphSurfaces[i]) {
+			continue;
+		}
+		int w = glyphSurfaces[i]->w;
+		int h = glyphSurfaces[i]->h;
+		if (penX + w > atlasWidth) {
+			penX = 0;
+			penY += rowHeight + padding;
+			rowHeight = 0;
+		}
+		glyphs[i].srcRect = { penX, penY, w, h };
+		penX += w + padding;
+		rowHeight = std::max(rowHeight, h);
+	}
+	const int atlasHeight = penY + rowHeight;
+
+	SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, std::max(atlasHeight, 1), 32, SDL_PIXELFORMAT_RGBA32);
+	for (int i = 0; i < numGlyphs; i++) {
+		if (glyphSurfaces[i]) {
+			// copy alpha as is rather than blending onto the empty atlas
+			SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(glyphSurfaces[i], NULL, atlasSurface, &glyphs[i].srcRect);
+			SDL_FreeSurface(glyphSurfaces[i]);
+		}
+	}
+
+	if (texture) {
+		SDL_DestroyTexture(texture);
+	}
+	texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+	SDL_FreeSurface(atlasSurface);
+	if (!texture) {
+		Logger::Err("Could not create glyph atlas texture: " + std::string(SDL_GetError()));
+		return false;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	lineHeight = TTF_FontHeight(font);
+	id = nextId++;
+	return true;
+}
+
+SDL_Texture* GlyphAtlas::GetTexture() const {
+	return texture;
+}
+
+const Glyph* GlyphAtlas::GetGlyph(char character) const {
+	if (character < FIRST_GLYPH || character > LAST_GLYPH) {
+		return nullptr;
+	}
+	return &glyphs[character - FIRST_GLYPH];
+}
+
+int GlyphAtlas::GetLineHeight() const {
+	return lineHeight;
+}
+
+uint32_t GlyphAtlas::GetId() const {
+	return id;
+}
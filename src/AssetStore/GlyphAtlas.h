@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <cstdint>
+
+struct Glyph {
+	SDL_Rect srcRect;	// cell of the glyph inside the atlas texture
+	int advance;		// horizontal pen advance after drawing the glyph
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// GlyphAtlas
+////////////////////////////////////////////////////////////////////////////////
+// All printable ASCII glyphs of one font (and size) rasterized once, in white,
+// into a single texture. Text is drawn by copying glyph cells and tinting them,
+// so no text ever goes through TTF_RenderText at frame time.
+////////////////////////////////////////////////////////////////////////////////
+class GlyphAtlas {
+	private:
+		SDL_Texture* texture;
+		Glyph glyphs[95];
+		int lineHeight;
+		uint32_t id;
+
+		static uint32_t nextId;
+
+	public:
+		static const char FIRST_GLYPH = 32;
+		static const char LAST_GLYPH = 126;
+
+		GlyphAtlas();
+		~GlyphAtlas();
+
+		bool Build(SDL_Renderer* renderer, TTF_Font* font);
+
+		SDL_Texture* GetTexture() const;
+		const Glyph* GetGlyph(char character) const;
+		int GetLineHeight() const;
+
+		// Unique per built atlas, lets caches tell atlases apart even if memory is reused
+		uint32_t GetId() const;
+};
@@ -0,0 +1,64 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <iterator>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+	data = nullptr;
+	size = 0;
+	isMapped = false;
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filePath) {
+	Close();
+
+#ifndef _WIN32
+	int fd = open(filePath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+		void* mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			data = static_cast<const uint8_t*>(mapping);
+			size = fileStat.st_size;
+			isMapped = true;
+		}
+	}
+	close(fd); // the mapping stays valid
+#endif
+	if (!data) {
+		std::ifstream file(filePath, std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		size = contents.size();
+		contents.push_back(0); // so an empty file still has data
+		data = contents.data();
+	}
+	return true;
+}
+
+void MappedFile::Close() {
+#ifndef _WIN32
+	if (isMapped) {
+		munmap(const_cast<uint8_t*>(data), size);
+	}
+#endif
+	data = nullptr;
+	size = 0;
+	isMapped = false;
+	contents.clear();
+	contents.shrink_to_fit();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// MappedFile
+////////////////////////////////////////////////////////////////////////////////
+// A whole file as read-only memory. Memory mapped where mmap is available, so
+// only the pages that get touched are ever read; read into a buffer elsewhere.
+////////////////////////////////////////////////////////////////////////////////
+class MappedFile {
+	private:
+		const uint8_t* data;
+		size_t size;
+		bool isMapped;
+		std::vector<uint8_t> contents; // used where mmap is not available
+
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& filePath);
+		void Close();
+
+		bool IsOpen() const { return data != nullptr; }
+		bool IsMapped() const { return isMapped; }
+		const uint8_t* GetData() const { return data; }
+		size_t GetSize() const { return size; }
+};
@@ -0,0 +1,117 @@
+#include "TexturePacker.h"
+#include <algorithm>
+#include <numeric>
+
+TexturePacker::TexturePacker(int pageWidth, int pageHeight, int padding):
+	pageWidth(pageWidth), pageHeight(pageHeight), padding(padding) {}
+
+int TexturePacker::GetNumPages() const {
+	return static_cast<int>(skylines.size());
+}
+
+// Lowest y a rectangle can sit at when its left edge is at the given node, -1 if it doesn't fit
+int TexturePacker::FindFitY(const std::vector<SkylineNode>& skyline, size_t nodeIndex, int width, int height) const {
+	if (skyline[nodeIndex].x + width > pageWidth) {
+		return -1;
+	}
+	int y = skyline[nodeIndex].y;
+	int widthLeft = width;
+	for (size_t i = nodeIndex; widthLeft > 0; i++) {
+		if (i >= skyline.size()) {
+			return -1;
+		}
+		y = std::max(y, skyline[i].y);
+		if (y + height > pageHeight) {
+			return -1;
+		}
+		widthLeft -= skyline[i].width;
+	}
+	return y;
+}
+
+void TexturePacker::AddSkylineLevel(std::vector<SkylineNode>& skyline, size_t nodeIndex, int x, int y, int width, int height) {
+	skyline.insert(skyline.begin() + nodeIndex, SkylineNode{ x, y + height, width });
+
+	// Nodes now covered by the new level shrink or disappear
+	for (size_t i = nodeIndex + 1; i < skyline.size();) {
+		const SkylineNode& previous = skyline[i - 1];
+		int overlap = previous.x + previous.width - skyline[i].x;
+		if (overlap <= 0) {
+			break;
+		}
+		skyline[i].x += overlap;
+		skyline[i].width -= overlap;
+		if (skyline[i].width <= 0) {
+			skyline.erase(skyline.begin() + i);
+		} else {
+			break;
+		}
+	}
+
+	// Neighbours at the same height become one node
+	for (size_t i = 0; i + 1 < skyline.size();) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		} else {
+			i++;
+		}
+	}
+}
+
+bool TexturePacker::Insert(std::vector<SkylineNode>& skyline, int width, int height, int& x, int& y) {
+	int bestY = pageHeight;
+	int bestWidth = pageWidth;
+	int bestIndex = -1;
+	for (size_t i = 0; i < skyline.size(); i++) {
+		int fitY = FindFitY(skyline, i, width, height);
+		if (fitY < 0) {
+			continue;
+		}
+		// bottom-left rule, ties go to the narrower node to leave less waste
+		if (fitY + height < bestY || (fitY + height == bestY && skyline[i].width < bestWidth)) {
+			bestY = fitY + height;
+			bestWidth = skyline[i].width;
+			bestIndex = static_cast<int>(i);
+			x = skyline[i].x;
+			y = fitY;
+		}
+	}
+	if (bestIndex < 0) {
+		return false;
+	}
+	AddSkylineLevel(skyline, bestIndex, x, y, width, height);
+	return true;
+}
+
+std::vector<TexturePacker::Placement> TexturePacker::Pack(const std::vector<SDL_Point>& sizes) {
+	std::vector<Placement> placements(sizes.size(), Placement{ -1, 0, 0 });
+
+	// Tallest first packs noticeably tighter
+	std::vector<size_t> order(sizes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+		return sizes[a].y > sizes[b].y;
+	});
+
+	for (auto index: order) {
+		int width = sizes[index].x + padding;
+		int height = sizes[index].y + padding;
+		if (width > pageWidth || height > pageHeight) {
+			continue; // caller keeps this one as its own texture
+		}
+
+		Placement& placement = placements[index];
+		for (size_t page = 0; page < skylines.size() && placement.page < 0; page++) {
+			if (Insert(skylines[page], width, height, placement.x, placement.y)) {
+				placement.page = static_cast<int>(page);
+			}
+		}
+		if (placement.page < 0) {
+			skylines.push_back({ SkylineNode{ 0, 0, pageWidth } });
+			Insert(skylines.back(), width, height, placement.x, placement.y);
+			placement.page = static_cast<int>(skylines.size()) - 1;
+		}
+	}
+	return placements;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// TexturePacker
+////////////////////////////////////////////////////////////////////////////////
+// Skyline bottom-left packer. Places rectangles into as few fixed size pages
+// as it can; every page keeps a skyline (the top edge of everything placed so
+// far) and a rectangle goes where it ends up lowest.
+////////////////////////////////////////////////////////////////////////////////
+class TexturePacker {
+	public:
+		struct Placement {
+			int page;	// -1 if the rectangle does not fit in a page at all
+			int x;
+			int y;
+		};
+
+	private:
+		struct SkylineNode {
+			int x;
+			int y;
+			int width;
+		};
+
+		int pageWidth;
+		int pageHeight;
+		int padding;
+		std::vector<std::vector<SkylineNode>> skylines;
+
+		int FindFitY(const std::vector<SkylineNode>& skyline, size_t nodeIndex, int width, int height) const;
+		bool Insert(std::vector<SkylineNode>& skyline, int width, int height, int& x, int& y);
+		void AddSkylineLevel(std::vector<SkylineNode>& skyline, size_t nodeIndex, int x, int y, int width, int height);
+
+	public:
+		TexturePacker(int pageWidth, int pageHeight, int padding = 1);
+
+		// Returns one placement per size, in input order
+		std::vector<Placement> Pack(const std::vector<SDL_Point>& sizes);
+		int GetNumPages() const;
+};
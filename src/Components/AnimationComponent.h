@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include "../SimulationClock/SimulationClock.h"
 
 struct AnimationComponent {
 	int numFrames;
@@ -11,6 +12,6 @@ struct AnimationComponent {
 
 	AnimationComponent(int numFrames = 1, int frameSpeedRate = 1, bool isLoop = true): numFrames(numFrames), frameSpeedRate(frameSpeedRate), isLoop(isLoop) {
 		this->currentFrame = 1;
-		this->startTime = SDL_GetTicks();
+		this->startTime = SimulationClock::GetTicks();
 	}
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "TransformComponent.h"
+#include "RigidBodyComponent.h"
+#include "SpriteComponent.h"
+#include "AnimationComponent.h"
+#include "BoxColliderComponent.h"
+#include "HealthComponent.h"
+#include "ProjectileEmitterComponent.h"
+#include "KeyboardControlComponent.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <tuple>
+
+////////////////////////////////////////////////////////////////////////////////
+// ComponentReflection
+////////////////////////////////////////////////////////////////////////////////
+// The fields scripts see, one description per type: the name it goes by and
+// its fields by name. Components are also reachable from an entity under
+// their name (entity.transform); the value types they use (vec2, rect) are
+// only reached through them. Names match the keys Level scripts use.
+////////////////////////////////////////////////////////////////////////////////
+template <typename TClass, typename TField>
+struct ReflectedField {
+	const char* name;
+	TField TClass::* member;
+};
+
+template <typename TClass, typename TField>
+ReflectedField<TClass, TField> Reflect(const char* name, TField TClass::* member) {
+	return { name, member };
+}
+
+template <typename T>
+struct ComponentReflection;
+
+template <>
+struct ComponentReflection<glm::vec2> {
+	static constexpr const char* name = "vec2";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("x", &glm::vec2::x),
+			Reflect("y", &glm::vec2::y)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<SDL_Rect> {
+	static constexpr const char* name = "rect";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("x", &SDL_Rect::x),
+			Reflect("y", &SDL_Rect::y),
+			Reflect("w", &SDL_Rect::w),
+			Reflect("h", &SDL_Rect::h)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<TransformComponent> {
+	static constexpr const char* name = "transform";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("position", &TransformComponent::position),
+			Reflect("scale", &TransformComponent::scale),
+			Reflect("rotation", &TransformComponent::rotation)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<RigidBodyComponent> {
+	static constexpr const char* name = "rigidbody";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("velocity", &RigidBodyComponent::velocity)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<SpriteComponent> {
+	static constexpr const char* name = "sprite";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("width", &SpriteComponent::width),
+			Reflect("height", &SpriteComponent::height),
+			Reflect("z_index", &SpriteComponent::zIndex),
+			Reflect("fixed", &SpriteComponent::isFixed),
+			Reflect("src_rect", &SpriteComponent::srcRect)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<AnimationComponent> {
+	static constexpr const char* name = "animation";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("num_frames", &AnimationComponent::numFrames),
+			Reflect("current_frame", &AnimationComponent::currentFrame),
+			Reflect("speed_rate", &AnimationComponent::frameSpeedRate),
+			Reflect("loop", &AnimationComponent::isLoop)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<BoxColliderComponent> {
+	static constexpr const char* name = "boxcollider";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("width", &BoxColliderComponent::width),
+			Reflect("height", &BoxColliderComponent::height),
+			Reflect("offset", &BoxColliderComponent::offset)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<HealthComponent> {
+	static constexpr const char* name = "health";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("health_percentage", &HealthComponent::healthPercentage)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<ProjectileEmitterComponent> {
+	static constexpr const char* name = "projectile_emitter";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("projectile_velocity", &ProjectileEmitterComponent::projectileVelocity),
+			Reflect("repeat_frequency", &ProjectileEmitterComponent::repeatFrequency),
+			Reflect("projectile_duration", &ProjectileEmitterComponent::projectileDuration),
+			Reflect("hit_percentage_damage", &ProjectileEmitterComponent::hitPercentDamage),
+			Reflect("friendly", &ProjectileEmitterComponent::isFriendly)
+		);
+	}
+};
+
+template <>
+struct ComponentReflection<KeyboardControlComponent> {
+	static constexpr const char* name = "keyboard_controller";
+	static auto Fields() {
+		return std::make_tuple(
+			Reflect("up_velocity", &KeyboardControlComponent::upVelocity),
+			Reflect("right_velocity", &KeyboardControlComponent::rightVelocity),
+			Reflect("down_velocity", &KeyboardControlComponent::downVelocity),
+			Reflect("left_velocity", &KeyboardControlComponent::leftVelocity)
+		);
+	}
+};
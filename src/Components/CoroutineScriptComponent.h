@@ -0,0 +1,10 @@
+#pragma once
+
+#include <sol/sol.hpp>
+
+// A script run as a coroutine, it can wait() instead of being called each frame
+struct CoroutineScriptComponent {
+	sol::function func;
+
+	CoroutineScriptComponent(sol::function func = sol::lua_nil): func(func) {}
+};
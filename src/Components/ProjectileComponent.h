@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
+#include "../SimulationClock/SimulationClock.h"
 
 
 struct ProjectileComponent {
@@ -18,6 +19,6 @@ struct ProjectileComponent {
 		isFriendly(isFriendly), 
 		hitPercentDamage(hitPercentDamage), 
 		duration(duration), 
-		startTime(SDL_GetTicks()
+		startTime(SimulationClock::GetTicks()
 	) {}
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <SDL2/SDL.h>
 #include <glm/glm.hpp>
+#include "../SimulationClock/SimulationClock.h"
 
 struct ProjectileEmitterComponent {
 	glm::vec2 projectileVelocity;
@@ -23,6 +24,6 @@ struct ProjectileEmitterComponent {
 		projectileDuration(projectileDuration), 
 		hitPercentDamage(hitPercentDamage),
 		isFriendly(isFriendly),
-		lastEmissionTime(SDL_GetTicks())
+		lastEmissionTime(SimulationClock::GetTicks())
 	{}
 };
\ No newline at end of file
@@ -1,11 +1,11 @@
 #pragma once
 
 #include "../ECS/ECS.h"
-#include <string>
+#include "../AssetStore/AssetHandle.h"
 #include <SDL2/SDL.h>
 
 struct SpriteComponent {
-	std::string assetId;
+	TextureHandle texture;
 	int width;
 	int height;
 	int zIndex;
@@ -14,7 +14,7 @@ struct SpriteComponent {
 	SDL_Rect srcRect;
 
 	SpriteComponent(
-		std::string assetId = "", 
+		TextureHandle texture = TextureHandle(), 
 		int width = 0, 
 		int height = 0, 
 		int zIndex = 0,
@@ -22,7 +22,7 @@ struct SpriteComponent {
 		int srcRectX = 0, 
 		int srcRectY = 0
 	): 
-		assetId(assetId), 
+		texture(texture), 
 		width(width), 
 		height(height),
 		zIndex(zIndex),
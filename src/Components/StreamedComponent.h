@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Marks entities the LevelStreamer spawned from a region. Holds what the
+// live components don't, so the entity can be written back when its region
+// goes dormant: its group, as an index into the level's strings (-1 = none)
+struct StreamedComponent {
+	int32_t group;
+
+	StreamedComponent(int32_t group = -1): group(group) {}
+};
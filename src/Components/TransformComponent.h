@@ -8,6 +8,10 @@ struct TransformComponent {
 	glm::vec2 scale;
 	double rotation;
 
+	// State at the start of the current tick, rendering blends towards the current state
+	glm::vec2 previousPosition;
+	double previousRotation;
+
 	TransformComponent(
 		glm::vec2 position = glm::vec2(0, 0), 
 		glm::vec2 scale = glm::vec2(1, 1), 
@@ -16,5 +20,16 @@ struct TransformComponent {
 		this->position = position;
 		this-> scale = scale;
 		this-> rotation = rotation;
+		this->previousPosition = position;
+		this->previousRotation = rotation;
 	};
+
+	// alpha is how far (0..1) rendering is between the previous and current tick
+	glm::vec2 GetInterpolatedPosition(double alpha) const {
+		return previousPosition + (position - previousPosition) * static_cast<float>(alpha);
+	}
+
+	double GetInterpolatedRotation(double alpha) const {
+		return previousRotation + (rotation - previousRotation) * alpha;
+	}
 };
\ No newline at end of file
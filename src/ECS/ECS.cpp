@@ -28,12 +28,18 @@ bool Entity::BelongsToGroup(const std::string& group) const {
 
 void System::AddEntityToSystem(Entity entity) {
 	entities.push_back(entity);
+	OnEntityAdded(entity);
 }
 
 void System::RemoveEntityFromSystem(Entity entity) {
-	entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](Entity other) {
+	auto removed = std::remove_if(entities.begin(), entities.end(), [&entity](Entity other) {
 		return entity == other;
-	}), entities.end());
+	});
+	if (removed == entities.end()) {
+		return; // entity was never part of this system
+	}
+	entities.erase(removed, entities.end());
+	OnEntityRemoved(entity);
 }
 
 std::vector<Entity> System::GetSystemEntities() const {
@@ -68,10 +74,51 @@ Entity Registry::CreateEntity() {
 	return entity;
 }
 
+// Same as count CreateEntity calls, with one log line and one resize, for level loads
+std::vector<Entity> Registry::CreateEntities(size_t count) {
+	std::vector<Entity> entities;
+	entities.reserve(count);
+	for (size_t i = 0; i < count; i++) {
+		size_t entityId;
+		if (freeIds.empty()) {
+			entityId = numEntities++;
+		} else {
+			entityId = freeIds.front();
+			freeIds.pop_front();
+		}
+		Entity entity(entityId);
+		entity.registry = this;
+		entitiesToBeAdded.insert(entity);
+		entities.push_back(entity);
+	}
+	if (numEntities > entityComponentSignatures.size()) {
+		entityComponentSignatures.resize(numEntities);
+	}
+
+	Logger::Log("Created " + std::to_string(count) + " entities");
+	return entities;
+}
+
 void Registry::KillEntity(Entity entity) {
 	entitiesToBeKilled.insert(entity);
 }
 
+bool Registry::IsEntityPendingKill(Entity entity) const {
+	return entitiesToBeKilled.find(entity) != entitiesToBeKilled.end();
+}
+
+// eg when switching levels, they go at the next registry update like any other kill
+void Registry::KillAllEntities() {
+	std::set<size_t> freeIdSet(freeIds.begin(), freeIds.end());
+	for (size_t entityId = 0; entityId < numEntities; entityId++) {
+		if (freeIdSet.find(entityId) == freeIdSet.end()) {
+			Entity entity(entityId);
+			entity.registry = this;
+			entitiesToBeKilled.insert(entity);
+		}
+	}
+}
+
 // if entity has all components required by a system, add to system
 void Registry::AddEntityToSystems(Entity entity) {
 	const auto entityId = entity.GetId();
@@ -79,13 +79,17 @@ class System {
 
 	public:
 		System() = default;
-		~System() = default;
+		virtual ~System() = default;
 
 		void AddEntityToSystem(Entity entity);
 		void RemoveEntityFromSystem(Entity entity);
 		std::vector<Entity> GetSystemEntities() const;
 		const Signature& GetComponentSignature() const;
 		template <typename TComponent> void RequireComponent();
+
+		// Hooks for systems that keep their own per entity state
+		virtual void OnEntityAdded(Entity entity) {}
+		virtual void OnEntityRemoved(Entity entity) {}
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -240,7 +244,13 @@ class Registry {
 
 		// Entity management
 		Entity CreateEntity();
+		std::vector<Entity> CreateEntities(size_t count);
 		void KillEntity(Entity entity);
+		void KillAllEntities();
+		// Killed this tick, still in its systems until the next Update
+		bool IsEntityPendingKill(Entity entity) const;
+		// Created and not yet killed, pending ones included
+		size_t GetNumEntities() const { return numEntities - freeIds.size(); }
 
 		// Component management
 		template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
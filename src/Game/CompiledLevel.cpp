@@ -0,0 +1,231 @@
+#include "CompiledLevel.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+	const char LEVEL_FILE_MAGIC[4] = { 'L', 'V', 'L', 'B' };
+	const uint32_t LEVEL_FILE_VERSION = 2;
+
+	class LevelWriter {
+		private:
+			std::ofstream& file;
+
+		public:
+			LevelWriter(std::ofstream& file): file(file) {}
+
+			template <typename T> void Write(const T& value) {
+				file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+			void Write(const std::string& value) {
+				Write<uint32_t>(value.size());
+				file.write(value.data(), value.size());
+			}
+			template <typename T> void WriteArray(const std::vector<T>& values) {
+				Write<uint32_t>(values.size());
+				file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+			}
+	};
+
+	// Bounds checked, a truncated or corrupt file just fails the read
+	class LevelReader {
+		private:
+			const std::vector<char>& data;
+			size_t position;
+			bool isOk;
+
+			bool Take(void* destination, size_t size) {
+				if (!isOk || size > data.size() - position) {
+					isOk = false;
+					return false;
+				}
+				std::memcpy(destination, data.data() + position, size);
+				position += size;
+				return true;
+			}
+
+		public:
+			LevelReader(const std::vector<char>& data): data(data), position(0), isOk(true) {}
+
+			bool IsOk() const { return isOk; }
+
+			template <typename T> void Read(T& value) {
+				Take(&value, sizeof(T));
+			}
+			void Read(std::string& value) {
+				uint32_t size = 0;
+				Read(size);
+				if (isOk && size <= data.size() - position) {
+					value.assign(data.data() + position, size);
+					position += size;
+				} else {
+					isOk = false;
+				}
+			}
+			template <typename T> void ReadArray(std::vector<T>& values) {
+				uint32_t count = 0;
+				Read(count);
+				if (isOk && count <= (data.size() - position) / sizeof(T)) {
+					values.resize(count);
+					Take(values.data(), count * sizeof(T));
+				} else {
+					isOk = false;
+				}
+			}
+	};
+}
+
+uint64_t CompiledLevel::HashFile(const std::string& filePath) {
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		return 0;
+	}
+	uint64_t hash = 14695981039346656037ull; // FNV-1a
+	char buffer[64 * 1024];
+	while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+		for (std::streamsize i = 0; i < file.gcount(); i++) {
+			hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+bool CompiledLevel::Write(const std::string& filePath) const {
+	for (const auto& chunk: scriptChunks) {
+		if (chunk.empty()) {
+			Logger::Err("Level has scripts that could not be precompiled, not writing " + filePath);
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(filePath).parent_path(), error);
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		Logger::Err("Could not write " + filePath);
+		return false;
+	}
+
+	LevelWriter writer(file);
+	file.write(LEVEL_FILE_MAGIC, sizeof(LEVEL_FILE_MAGIC));
+	writer.Write(LEVEL_FILE_VERSION);
+	writer.Write(sourceHash);
+	writer.Write(luaVersion);
+
+	writer.Write<uint32_t>(strings.size());
+	for (const auto& value: strings) {
+		writer.Write(value);
+	}
+	writer.Write<uint32_t>(textureAssets.size());
+	for (const auto& asset: textureAssets) {
+		writer.Write(asset.assetId);
+		writer.Write(asset.filePath);
+	}
+	writer.Write<uint32_t>(fontAssets.size());
+	for (const auto& asset: fontAssets) {
+		writer.Write(asset.assetId);
+		writer.Write(asset.filePath);
+		writer.Write<int32_t>(asset.fontSize);
+	}
+
+	writer.Write(mapTextureAssetId);
+	writer.Write(mapNumRows);
+	writer.Write(mapNumCols);
+	writer.Write(tileSize);
+	writer.Write(mapScale);
+	writer.Write(mapFile);
+
+	writer.WriteArray(entities);
+	writer.WriteArray(componentData);
+
+	writer.Write<uint32_t>(scriptChunks.size());
+	for (const auto& chunk: scriptChunks) {
+		writer.Write(chunk);
+	}
+	writer.Write<uint32_t>(globals.size());
+	for (const auto& global: globals) {
+		writer.Write(global.name);
+		writer.Write<int32_t>(static_cast<int32_t>(global.type));
+		writer.Write(global.number);
+		writer.Write(global.text);
+	}
+	return static_cast<bool>(file);
+}
+
+bool CompiledLevel::Read(const std::string& filePath) {
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	LevelReader reader(data);
+	char magic[4] = {};
+	uint32_t version = 0;
+	reader.Read(magic);
+	reader.Read(version);
+	if (!reader.IsOk() || std::memcmp(magic, LEVEL_FILE_MAGIC, sizeof(magic)) != 0 || version != LEVEL_FILE_VERSION) {
+		Logger::Err(filePath + " is not a compiled level, or from another version");
+		return false;
+	}
+	reader.Read(sourceHash);
+	reader.Read(luaVersion);
+
+	uint32_t count = 0;
+	reader.Read(count);
+	strings.resize(reader.IsOk() ? std::min<size_t>(count, data.size()) : 0);
+	for (auto& value: strings) {
+		reader.Read(value);
+	}
+	reader.Read(count);
+	textureAssets.resize(reader.IsOk() ? std::min<size_t>(count, data.size()) : 0);
+	for (auto& asset: textureAssets) {
+		reader.Read(asset.assetId);
+		reader.Read(asset.filePath);
+	}
+	reader.Read(count);
+	fontAssets.resize(reader.IsOk() ? std::min<size_t>(count, data.size()) : 0);
+	for (auto& asset: fontAssets) {
+		int32_t fontSize = 0;
+		reader.Read(asset.assetId);
+		reader.Read(asset.filePath);
+		reader.Read(fontSize);
+		asset.fontSize = fontSize;
+	}
+
+	reader.Read(mapTextureAssetId);
+	reader.Read(mapNumRows);
+	reader.Read(mapNumCols);
+	reader.Read(tileSize);
+	reader.Read(mapScale);
+	reader.Read(mapFile);
+	mapTiles.clear();
+
+	reader.ReadArray(entities);
+	reader.ReadArray(componentData);
+
+	reader.Read(count);
+	scriptChunks.resize(reader.IsOk() ? std::min<size_t>(count, data.size()) : 0);
+	for (auto& chunk: scriptChunks) {
+		reader.Read(chunk);
+	}
+	scriptFunctions.clear();
+	reader.Read(count);
+	globals.resize(reader.IsOk() ? std::min<size_t>(count, data.size()) : 0);
+	for (auto& global: globals) {
+		int32_t type = 0;
+		reader.Read(global.name);
+		reader.Read(type);
+		reader.Read(global.number);
+		reader.Read(global.text);
+		global.type = static_cast<sol::type>(type);
+	}
+
+	if (!reader.IsOk()) {
+		Logger::Err(filePath + " is truncated");
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "../AssetStore/AssetStore.h"
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Compiled level records
+////////////////////////////////////////////////////////////////////////////////
+// Each entity is a LevelEntityRecord plus one record per component it has,
+// stored back to back in componentData in LevelComponentBits order. Records
+// are plain data so a level file is read with a handful of bulk copies.
+// Strings (tags, groups, sprite texture ids) are indices into the level's
+// string table, -1 when absent.
+////////////////////////////////////////////////////////////////////////////////
+enum LevelComponentBits: uint32_t {
+	LEVEL_TRANSFORM = 1 << 0,
+	LEVEL_RIGIDBODY = 1 << 1,
+	LEVEL_SPRITE = 1 << 2,
+	LEVEL_ANIMATION = 1 << 3,
+	LEVEL_BOXCOLLIDER = 1 << 4,
+	LEVEL_HEALTH = 1 << 5,
+	LEVEL_PROJECTILE_EMITTER = 1 << 6,
+	LEVEL_CAMERA_FOLLOW = 1 << 7,	// no record
+	LEVEL_KEYBOARD_CONTROL = 1 << 8,
+	LEVEL_SCRIPT = 1 << 9,
+	LEVEL_COROUTINE_SCRIPT = 1 << 10
+};
+
+struct LevelEntityRecord {
+	uint32_t components;
+	int32_t tag;
+	int32_t group;
+	uint32_t dataOffset;	// first component record in componentData
+};
+
+struct TransformRecord {
+	float x, y;
+	float scaleX, scaleY;
+	double rotation;
+};
+
+struct RigidBodyRecord {
+	float velocityX, velocityY;
+};
+
+struct SpriteRecord {
+	int32_t texture;
+	int32_t width, height;
+	int32_t zIndex;
+	int32_t isFixed;
+	int32_t srcRectX, srcRectY;
+};
+
+struct AnimationRecord {
+	int32_t numFrames;
+	int32_t frameSpeedRate;
+};
+
+struct BoxColliderRecord {
+	int32_t width, height;
+	float offsetX, offsetY;
+};
+
+struct HealthRecord {
+	int32_t healthPercentage;
+};
+
+struct ProjectileEmitterRecord {
+	float velocityX, velocityY;
+	int32_t repeatFrequency;	// ms
+	int32_t projectileDuration;	// ms
+	int32_t hitPercentDamage;
+	int32_t isFriendly;
+};
+
+struct KeyboardControlRecord {
+	float upX, upY;
+	float rightX, rightY;
+	float downX, downY;
+	float leftX, leftY;
+};
+
+struct ScriptRecord {
+	int32_t script;	// index into the level's scripts
+};
+
+struct CoroutineScriptRecord {
+	int32_t script;	// same scripts as ScriptRecord
+};
+
+// Globals the level script sets besides Level itself (eg map_width), entity scripts read them
+struct LevelGlobal {
+	std::string name;
+	sol::type type;		// number, string or boolean
+	double number;
+	std::string text;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// CompiledLevel
+////////////////////////////////////////////////////////////////////////////////
+// Everything a Level script describes, with the Lua already evaluated. Made by
+// LevelCompiler, either at load time or offline by the levelc tool, which
+// writes it to assets/levels/LevelN.bin for LevelLoader to read instead of
+// running the script.
+////////////////////////////////////////////////////////////////////////////////
+struct CompiledLevel {
+	uint64_t sourceHash = 0;	// of the script it was compiled from, stale files are ignored
+	std::string luaVersion;		// script bytecode only loads into the same Lua
+
+	std::vector<std::string> strings;
+	std::vector<TextureAssetInfo> textureAssets;
+	std::vector<FontAssetInfo> fontAssets;
+
+	int32_t mapTextureAssetId = -1;
+	int32_t mapNumRows = 0;
+	int32_t mapNumCols = 0;
+	int32_t tileSize = 0;
+	double mapScale = 1.0;
+	int32_t mapFile = -1;
+	// Read from mapFile (or its pack entry) every time the level loads, never
+	// stored, so an edited map or rebuilt pack shows up without a recompile
+	std::vector<uint16_t> mapTiles;
+
+	std::vector<LevelEntityRecord> entities;
+	std::vector<uint8_t> componentData;
+
+	// on_update_script and coroutine_script functions as precompiled chunks; when compiled at load
+	// time the live functions are kept too and used directly
+	std::vector<std::string> scriptChunks;
+	std::vector<sol::function> scriptFunctions;
+
+	std::vector<LevelGlobal> globals;
+
+	bool Write(const std::string& filePath) const;
+	bool Read(const std::string& filePath);
+
+	static uint64_t HashFile(const std::string& filePath);
+};
@@ -1,5 +1,6 @@
 #include "Game.h"
 #include "LevelLoader.h"
+#include "LuaCompat.h"
 #include "../Logger/Logger.h"
 #include "../ECS/ECS.h"
 #include "../Systems/MovementSystem.h"
@@ -15,6 +16,10 @@
 #include "../Systems/RenderHealthBarSystem.h"
 #include "../Systems/RenderGUISystem.h"
 #include "../Systems/ScriptSystem.h"
+#include "../Systems/CoroutineScriptSystem.h"
+#include "../Systems/TransformHistorySystem.h"
+#include "../Systems/StreamingSystem.h"
+#include "../SimulationClock/SimulationClock.h"
 #include "../EventBus/EventBus.h"
 #include "../Events/KeyPressedEvent.h"
 #include <glm/glm.hpp>
@@ -23,6 +28,10 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_sdl.h>
 #include <imgui/imgui_impl_sdl.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <vector>
 
 // set to constant (dont use displaymode dims) to use as logical dimensions
@@ -35,12 +44,29 @@ int Game::mapHeight;
 // double Game::entityTweak = 2.0;
 // double Game::tileTweak = 3.5;
 
-Game::Game() {
+Game::Game(const GameOptions& options): options(options) {
 	isRunning = false;
 	isDebug = false;
+	window = nullptr;
+	renderer = nullptr;
+	frameSurface = nullptr;
+	frameCount = 0;
+	levelNumber = 0;
+	previousFrameCounter = 0;
+	tickSeconds = 1.0 / options.tickRate;
+	accumulatedSeconds = 0.0;
+	interpolationAlpha = 1.0;
 	registry = std::make_unique<Registry>();
 	assetStore = std::make_unique<AssetStore>();
 	eventBus = std::make_unique<EventBus>();
+	threadPool = std::make_unique<ThreadPool>();
+	tileMap = std::make_unique<TileMap>();
+	renderThread = std::make_unique<RenderThread>(assetStore, tileMap, options.isRenderThreaded);
+	levelStreamer = std::make_unique<LevelStreamer>(*threadPool);
+	luaGarbageStepper = std::make_unique<LuaGarbageStepper>();
+	tickProfiler = std::make_unique<TickProfiler>();
+	levelPreloader = std::make_unique<LevelPreloader>(*threadPool);
+	lua = std::make_unique<sol::state>();
 	Logger::Log("Game construct called.");
 }
 
@@ -48,8 +74,44 @@ Game::~Game() {
 	Logger::Log("Game destructor called");
 }
 
+// Offscreen software renderer, no window or vsync. Frames are drawn straight
+// into frameSurface where they can be dumped
+bool Game::CreateHeadlessRenderer() {
+	windowWidth = options.headlessWidth;
+	windowHeight = options.headlessHeight;
+	frameSurface = SDL_CreateRGBSurfaceWithFormat(0, windowWidth, windowHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (!frameSurface) {
+		Logger::Err("Error creating headless surface: " + std::string(SDL_GetError()));
+		return false;
+	}
+	renderThread->Invoke([this]() {
+		renderer = SDL_CreateSoftwareRenderer(frameSurface);
+	});
+	if (!renderer) {
+		Logger::Err("Error creating headless renderer: " + std::string(SDL_GetError()));
+		return false;
+	}
+
+	if (!options.frameDumpDir.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(options.frameDumpDir, error);
+		if (error) {
+			Logger::Err("Could not create frame dump dir " + options.frameDumpDir);
+		}
+	}
+	Logger::Log("Headless renderer " + std::to_string(windowWidth) + "x" + std::to_string(windowHeight));
+	return true;
+}
+
 void Game::Initialize() {
-	if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+	if (options.isHeadless) {
+		// no display on CI machines, keep env overrides if set
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+	}
+	// simulating needs no video, audio or input, textures go to the offscreen renderer
+	const Uint32 sdlFlags = options.simulateTicks > 0 ? SDL_INIT_TIMER | SDL_INIT_EVENTS : SDL_INIT_EVERYTHING;
+	if (SDL_Init(sdlFlags) != 0) {
 		Logger::Err("Error initializing SDL");
 		return;
 	}
@@ -58,6 +120,29 @@ void Game::Initialize() {
 		Logger::Err("Error initializing SDL TTF");
 		return;
 	}
+
+	// load image decoders up front, IMG_Load runs on pool threads later
+	IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+
+	if (options.isHeadless) {
+		if (!CreateHeadlessRenderer()) {
+			return;
+		}
+		ImGui::CreateContext();
+		renderThread->Invoke([this]() {
+			renderThread->SetRenderer(renderer);
+			ImGuiSDL::Initialize(renderer, windowWidth, windowHeight);
+		});
+
+		camera.x = 0;
+		camera.y = 0;
+		camera.w = windowWidth;
+		camera.h = windowHeight;
+
+		isRunning = true;
+		return;
+	}
+
 	SDL_DisplayMode displayMode;
 	SDL_GetCurrentDisplayMode(0, &displayMode);
 	windowWidth = displayMode.w;
@@ -74,9 +159,12 @@ void Game::Initialize() {
 		Logger::Err("Error creating SDL window.");
 		return;
 	}
-	renderer = SDL_CreateRenderer(window, -1, 
-		SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC // use both if possible
-	);
+	// Renderer lives on the render thread, a GL context can only be current on one thread
+	renderThread->Invoke([this]() {
+		renderer = SDL_CreateRenderer(window, -1, 
+			SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC // use both if possible
+		);
+	});
 	if (!renderer) {
 		Logger::Err("Error creating SDL renderer.");
 		return;
@@ -84,7 +172,10 @@ void Game::Initialize() {
 
 	// Init ImGui context
 	ImGui::CreateContext();
-	ImGuiSDL::Initialize(renderer, windowWidth, windowHeight);
+	renderThread->Invoke([this]() {
+		renderThread->SetRenderer(renderer);
+		ImGuiSDL::Initialize(renderer, windowWidth, windowHeight);
+	});
 
 	SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
 
@@ -97,28 +188,143 @@ void Game::Initialize() {
 	isRunning = true;
 }
 
+// Every level's registry gets the same systems, preloaded ones included
+void Game::AddSystems(Registry& levelRegistry) {
+	levelRegistry.AddSystem<MovementSystem>();
+	levelRegistry.AddSystem<RenderSystem>();
+	levelRegistry.AddSystem<AnimationSystem>();
+	levelRegistry.AddSystem<CollisionSystem>();
+	levelRegistry.AddSystem<DamageSystem>();
+	levelRegistry.AddSystem<KeyboardControlSystem>();
+	levelRegistry.AddSystem<CameraMovementSystem>();
+	levelRegistry.AddSystem<ProjectileEmitSystem>();
+	levelRegistry.AddSystem<ProjectileLifecycleSystem>();
+	levelRegistry.AddSystem<RenderTextSystem>();
+	levelRegistry.AddSystem<RenderHealthBarSystem>();
+	levelRegistry.AddSystem<RenderGUISystem>();
+	levelRegistry.AddSystem<ScriptSystem>();
+	levelRegistry.GetSystem<ScriptSystem>().SetBudget(options.scriptBudgetMs / 1000.0);
+	levelRegistry.AddSystem<CoroutineScriptSystem>();
+	levelRegistry.AddSystem<TransformHistorySystem>();
+	levelRegistry.AddSystem<StreamingSystem>();
+}
+
+void Game::SetupLua(sol::state& levelLua, Registry& levelRegistry) {
+	// Libraries first, the bindings' Lua side picks up base functions when it's loaded
+	LuaCompat::OpenLibraries(levelLua);
+
+	// Create C++ -> Lua bindings
+	levelRegistry.GetSystem<ScriptSystem>().CreateLuaBindings(levelLua);
+	levelRegistry.GetSystem<CoroutineScriptSystem>().CreateLuaBindings(levelLua);
+}
+
 void Game::Setup() {
 	// Add systems that need to be processed
-	registry->AddSystem<MovementSystem>();
-	registry->AddSystem<RenderSystem>();
-	registry->AddSystem<AnimationSystem>();
-	registry->AddSystem<CollisionSystem>();
-	registry->AddSystem<DamageSystem>();
-	registry->AddSystem<KeyboardControlSystem>();
-	registry->AddSystem<CameraMovementSystem>();
-	registry->AddSystem<ProjectileEmitSystem>();
-	registry->AddSystem<ProjectileLifecycleSystem>();
-	registry->AddSystem<RenderTextSystem>();
-	registry->AddSystem<RenderHealthBarSystem>();
-	registry->AddSystem<RenderGUISystem>();
-	registry->AddSystem<ScriptSystem>();
+	AddSystems(*registry);
+	SetupLua(*lua, *registry);
 
-	// Create C++ -> Lua bindings
-	registry->GetSystem<ScriptSystem>().CreateLuaBindings(lua);
+	// Built with `make pack`, levels fall back to the loose files without it
+	assetStore->OpenPack("./assets/assets.pack");
+	assetStore->SetTextureBudget(size_t(options.textureBudgetMegabytes) * 1024 * 1024);
+	LoadLevel(options.startLevel);
+}
 
-	lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::os);
-	LevelLoader loader; // why not pass pointer to registry/assetSt/renderer in constructor?
-	loader.LoadLevel(lua, registry, assetStore, renderer, 1);
+// The level L switches to next is built while this one plays. Systems are
+// added here on the main thread, so every component type has its id before
+// the preloader's thread creates components
+void Game::PreloadLevel(int level) {
+	auto preloadRegistry = std::make_unique<Registry>();
+	AddSystems(*preloadRegistry);
+	auto preloadLua = std::make_unique<sol::state>();
+	SetupLua(*preloadLua, *preloadRegistry);
+	levelPreloader->Start(level, std::move(preloadLua), std::move(preloadRegistry), assetStore);
+}
+
+void Game::LoadLevel(int level) {
+	// the render thread may still be drawing the old level
+	renderThread->WaitIdle();
+
+	// A level preloaded in the background is finished if need be and swapped
+	// in, a preload of any other level is dropped
+	if (levelPreloader->GetLevelNumber() == level) {
+		levelPreloader->Update(assetStore, *renderThread, true);
+	}
+	const bool isPreloaded = levelPreloader->GetLevelNumber() == level && levelPreloader->GetState() == PRELOAD_READY;
+	if (!isPreloaded) {
+		levelPreloader->Cancel(assetStore);
+	}
+
+	if (levelNumber > 0) {
+		levelStreamer->Clear();
+		if (!isPreloaded) {
+			registry->KillAllEntities();
+			registry->Update();
+		}
+		renderThread->Invoke([this]() {
+			tileMap->Clear();
+		});
+	}
+
+	// The new level takes its references before the old one lets go, so the
+	// assets they share stay resident and are not loaded again
+	LevelAssets previousAssets = std::move(levelAssets);
+	if (isPreloaded) {
+		PreloadedLevel preloaded = levelPreloader->Take();
+		// old streamer and registry go before the Lua state their scripts came from
+		levelStreamer = std::move(preloaded.levelStreamer);
+		registry = std::move(preloaded.registry);
+		lua = std::move(preloaded.lua);
+		// handlers still point at the old systems until the next tick subscribes the new ones
+		eventBus->Reset();
+
+		tileMap->Load(std::move(preloaded.mapTiles), preloaded.mapNumRows, preloaded.mapNumCols, preloaded.tileSize, preloaded.mapScale, preloaded.mapTexture);
+		Game::mapWidth = tileMap->GetWidth();
+		Game::mapHeight = tileMap->GetHeight();
+		levelAssets = std::move(preloaded.assets);
+		Logger::Log("Level " + std::to_string(level) + " swapped in from the preloader");
+	} else {
+		LevelLoader loader; // why not pass pointer to registry/assetSt/renderer in constructor?
+		levelAssets = loader.LoadLevel(*lua, registry, assetStore, tileMap, *renderThread, *threadPool, levelStreamer, level);
+	}
+	assetStore->Release(previousAssets);
+	renderThread->Invoke([this]() {
+		assetStore->Trim();
+	});
+	levelNumber = level;
+	// a preloaded level brought its own Lua state
+	luaGarbageStepper->Attach(lua->lua_state());
+
+	// start with the area around the player spawned, the rest streams in as the camera moves
+	registry->Update();
+	if (isPreloaded) {
+		// timers were stamped whenever the preload built them, they start now
+		const Uint32 now = SimulationClock::GetTicks();
+		for (auto entity: registry->GetSystem<AnimationSystem>().GetSystemEntities()) {
+			entity.GetComponent<AnimationComponent>().startTime = now;
+		}
+		for (auto entity: registry->GetSystem<ProjectileEmitSystem>().GetSystemEntities()) {
+			entity.GetComponent<ProjectileEmitterComponent>().lastEmissionTime = now;
+		}
+	}
+	registry->GetSystem<CameraMovementSystem>().Update(camera);
+	levelStreamer->LoadAround(registry, camera);
+	previousCamera = camera;
+
+	// Systems that create or draw with fixed assets get their handles once per level
+	registry->GetSystem<ProjectileEmitSystem>().SetProjectileTexture(assetStore->GetTextureHandle("bullet-texture"));
+	registry->GetSystem<RenderHealthBarSystem>().SetLabelFont(assetStore->GetFontHandle("pico8-font-5"));
+
+	const AssetCacheStats stats = assetStore->GetCacheStats();
+	Logger::Log(
+		"Level " + std::to_string(level) + " loaded, asset cache " + std::to_string(stats.hits) + " hits / " +
+		std::to_string(stats.misses) + " misses / " + std::to_string(stats.evictions) + " evictions, " +
+		std::to_string(stats.numTextures) + " textures + " + std::to_string(stats.numFonts) + " fonts in " +
+		std::to_string(stats.textureBytes / (1024 * 1024)) + " of " + std::to_string(stats.textureBudget / (1024 * 1024)) + " MB"
+	);
+
+	if (options.isPreloading) {
+		PreloadLevel(level % NUM_LEVELS + 1);
+	}
 }
 
 void Game::ProcessInput() {
@@ -138,6 +344,13 @@ void Game::ProcessInput() {
 			case SDL_QUIT:
 				isRunning = false;
 				break;
+			case SDL_RENDER_TARGETS_RESET:
+			case SDL_RENDER_DEVICE_RESET:
+				// baked tilemap chunks were lost with the render targets
+				renderThread->Invoke([this]() {
+					tileMap->InvalidateChunks();
+				});
+				break;
 			case SDL_KEYDOWN:
 				switch(sdlEvent.key.keysym.sym) {
 					case SDLK_ESCAPE:
@@ -146,6 +359,9 @@ void Game::ProcessInput() {
 					case SDLK_d:
 						isDebug = !isDebug;
 						break;
+					case SDLK_l:
+						LoadLevel(levelNumber % NUM_LEVELS + 1);
+						break;
 					default:
 						eventBus->EmitEvent<KeyPressedEvent>(sdlEvent.key.keysym.sym);
 						break;
@@ -155,18 +371,37 @@ void Game::ProcessInput() {
 	}
 }
 
+// Feeds real time into an accumulator and simulates it in fixed ticks,
+// whatever is left over decides how far rendering interpolates
 void Game::Update() {
-	// if too fast, waste time till reach desired frame length aka MILLISECS_PER_FRAME
-	// only works if update is fast, this is not frame-governed loop
-	int timeToWait = MILLISECS_PER_FRAME - (SDL_GetTicks() - millisecsPreviousFrame);
-	if (timeToWait > 0 && timeToWait <= MILLISECS_PER_FRAME) {
-		SDL_Delay(timeToWait);
+	const Uint64 frameCounter = SDL_GetPerformanceCounter();
+	double frameSeconds = (frameCounter - previousFrameCounter) / static_cast<double>(SDL_GetPerformanceFrequency());
+	previousFrameCounter = frameCounter;
+	if (frameSeconds > MAX_FRAME_SECONDS) {
+		frameSeconds = MAX_FRAME_SECONDS;
+	}
+	if (options.isHeadless) {
+		// run unthrottled but one tick per frame, so dumped frames are repeatable
+		frameSeconds = tickSeconds;
 	}
 
-	double dt = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
+	accumulatedSeconds += frameSeconds;
+	while (accumulatedSeconds >= tickSeconds) {
+		const Uint64 tickCounter = SDL_GetPerformanceCounter();
+		FixedUpdate(tickSeconds);
+		levelPreloader->AddTick((SDL_GetPerformanceCounter() - tickCounter) / static_cast<double>(SDL_GetPerformanceFrequency()));
+		accumulatedSeconds -= tickSeconds;
+	}
+	interpolationAlpha = accumulatedSeconds / tickSeconds;
 
-	// Store the now previous frame time
-	millisecsPreviousFrame = SDL_GetTicks();
+	// a preload in progress takes its next step, never waiting on it
+	levelPreloader->Update(assetStore, *renderThread);
+}
+
+void Game::FixedUpdate(double dt) {
+	tickProfiler->BeginTick();
+	SimulationClock::Advance(dt);
+	previousCamera = camera;
 
 	// Reset all event handlers for current frame
 	eventBus->Reset();
@@ -178,47 +413,152 @@ void Game::Update() {
 	registry->GetSystem<ProjectileEmitSystem>().SubscribeToEvents(eventBus);
 	registry->GetSystem<MovementSystem>().SubscribeToEvents(eventBus);
 
+	tickProfiler->Mark("event subscriptions");
+
 	// Update registry to process entities pending add/delete
 	registry->Update();
+	tickProfiler->Mark("registry");
 
 	// Invoke all systems that update
+	registry->GetSystem<TransformHistorySystem>().Update();
+	tickProfiler->Mark("TransformHistorySystem");
 	registry->GetSystem<MovementSystem>().Update(dt);
+	tickProfiler->Mark("MovementSystem");
 	registry->GetSystem<AnimationSystem>().Update();
-	registry->GetSystem<CollisionSystem>().Update(eventBus);
+	tickProfiler->Mark("AnimationSystem");
+	registry->GetSystem<CollisionSystem>().Update(eventBus, *threadPool);
+	tickProfiler->Mark("CollisionSystem");
 	registry->GetSystem<CameraMovementSystem>().Update(camera);
+	tickProfiler->Mark("CameraMovementSystem");
 	registry->GetSystem<ProjectileEmitSystem>().Update();
+	tickProfiler->Mark("ProjectileEmitSystem");
 	registry->GetSystem<ProjectileLifecycleSystem>().Update();
-	registry->GetSystem<ScriptSystem>().Update(dt, SDL_GetTicks());
+	tickProfiler->Mark("ProjectileLifecycleSystem");
+	registry->GetSystem<ScriptSystem>().Update(dt, SimulationClock::GetTicks());
+	tickProfiler->Mark("ScriptSystem");
+	registry->GetSystem<CoroutineScriptSystem>().Update(dt);
+	tickProfiler->Mark("CoroutineScriptSystem");
+	levelStreamer->Update(registry, camera);
+	tickProfiler->Mark("LevelStreamer");
 }
 
+// Records the frame, the render thread draws and presents it while the next one simulates
 void Game::Render() {
-	SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255);
-	SDL_RenderClear(renderer);
+	RenderCommandList& frame = renderThread->BeginFrame();
+	frame.AddClear({ 21, 21, 21, 255 });
 
-	registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera);
-	registry->GetSystem<RenderTextSystem>().Update(renderer, assetStore, camera);
-	registry->GetSystem<RenderHealthBarSystem>().Update(renderer, assetStore, camera);
+	// Camera follows interpolated sprites, so it is blended the same way
+	SDL_Rect renderCamera = camera;
+	renderCamera.x = previousCamera.x + static_cast<int>((camera.x - previousCamera.x) * interpolationAlpha);
+	renderCamera.y = previousCamera.y + static_cast<int>((camera.y - previousCamera.y) * interpolationAlpha);
+
+	frame.AddTileMap(renderCamera);
+	registry->GetSystem<RenderSystem>().Update(frame, assetStore, renderCamera, interpolationAlpha);
+	registry->GetSystem<RenderTextSystem>().Update(frame, renderCamera);
+	registry->GetSystem<RenderHealthBarSystem>().Update(frame, renderCamera, interpolationAlpha);
 	if (isDebug) {
-		registry->GetSystem<CollisionSystem>().Render(renderer, camera);
-		registry->GetSystem<RenderGUISystem>().Update(registry);
+		registry->GetSystem<CollisionSystem>().Render(frame, renderCamera);
+		registry->GetSystem<RenderGUISystem>().Update(registry, assetStore, registry->GetSystem<ScriptSystem>().GetProfiler(), luaGarbageStepper->GetStats(), frame);
 	}
 
-	SDL_RenderPresent(renderer); // paints window
+	renderThread->SubmitFrame(); // paints window
+
+	frameCount++;
+	if (frameSurface && !options.frameDumpDir.empty()) {
+		renderThread->Invoke([this]() {
+			DumpFrame();
+		});
+	}
+}
+
+void Game::DumpFrame() {
+	char fileName[32];
+	std::snprintf(fileName, sizeof(fileName), "frame_%05d.%s", frameCount, options.frameDumpFormat == FRAME_DUMP_RAW ? "raw" : "png");
+	const std::string path = options.frameDumpDir + "/" + fileName;
+
+	if (options.frameDumpFormat == FRAME_DUMP_PNG) {
+		if (IMG_SavePNG(frameSurface, path.c_str()) != 0) {
+			Logger::Err("Could not write frame " + path + ": " + IMG_GetError());
+		}
+		return;
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		Logger::Err("Could not write frame " + path);
+		return;
+	}
+	SDL_LockSurface(frameSurface);
+	const char* pixels = static_cast<const char*>(frameSurface->pixels);
+	for (int y = 0; y < frameSurface->h; y++) {
+		file.write(pixels + y * frameSurface->pitch, frameSurface->w * 4);
+	}
+	SDL_UnlockSurface(frameSurface);
 }
 
 void Game::Run() {
 	Setup();
+	previousFrameCounter = SDL_GetPerformanceCounter();
+	previousCamera = camera;
 	while (isRunning) {
 		ProcessInput();
 		Update();
 		Render();
+		// Lua's collector gets the time left before the next tick is due
+		const double frameSeconds = (SDL_GetPerformanceCounter() - previousFrameCounter) / static_cast<double>(SDL_GetPerformanceFrequency());
+		luaGarbageStepper->Step(std::min(MAX_GC_SECONDS, tickSeconds - accumulatedSeconds - frameSeconds));
+		if (options.maxFrames > 0 && frameCount >= options.maxFrames) {
+			isRunning = false;
+		}
+	}
+
+	if (options.isHeadless && frameCount > 0) {
+		renderThread->WaitIdle();
+		const double renderMs = renderThread->GetBusyCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+		Logger::Log("Rendered " + std::to_string(frameCount) + " frames, avg render " + std::to_string(renderMs / frameCount) + " ms");
 	}
 }
 
+// Runs options.simulateTicks fixed ticks back to back, with no input, nothing
+// drawn and no waiting on real time, then logs how fast and where time went
+void Game::Simulate() {
+	Setup();
+	tickProfiler->SetEnabled(true);
+	const Uint64 startCounter = SDL_GetPerformanceCounter();
+	int numTicks = 0;
+	for (; numTicks < options.simulateTicks && isRunning; numTicks++) {
+		FixedUpdate(tickSeconds);
+		// steps Lua's collector as a frame between ticks would, none of it idle
+		luaGarbageStepper->Step(0.0);
+		tickProfiler->Mark("Lua GC");
+	}
+	const double seconds = (SDL_GetPerformanceCounter() - startCounter) / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	Logger::Log(
+		"Simulated " + std::to_string(numTicks) + " ticks (" + std::to_string(numTicks * tickSeconds) + " s of game time) in " +
+		std::to_string(seconds) + " s: " + std::to_string(seconds > 0.0 ? numTicks / seconds : 0.0) + " ticks/s, " +
+		std::to_string(registry->GetNumEntities()) + " entities at the end"
+	);
+	tickProfiler->Log();
+}
+
 void Game::Destroy() {
-	ImGuiSDL::Deinitialize();
+	levelPreloader->Cancel(assetStore);
+	// textures go with the renderer, on the thread that owns it
+	renderThread->Invoke([this]() {
+		tileMap->Clear();
+		assetStore->ClearAssets();
+		ImGuiSDL::Deinitialize();
+		SDL_DestroyRenderer(renderer);
+	});
+	renderThread.reset();
 	ImGui::DestroyContext();
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
+	IMG_Quit();
+	if (window) {
+		SDL_DestroyWindow(window);
+	}
+	if (frameSurface) {
+		SDL_FreeSurface(frameSurface);
+	}
 	SDL_Quit();
 }
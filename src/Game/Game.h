@@ -5,37 +5,75 @@
 #include "../ECS/ECS.h"
 #include "../EventBus/EventBus.h"
 #include "../AssetStore/AssetStore.h"
+#include "../ThreadPool/ThreadPool.h"
+#include "../TileMap/TileMap.h"
+#include "../Renderer/RenderThread.h"
+#include "GameOptions.h"
+#include "LevelStreamer.h"
+#include "LevelPreloader.h"
+#include "LuaGarbageStepper.h"
+#include "TickProfiler.h"
 
-const int FPS = 60;
-const int MILLISECS_PER_FRAME = 1000 / FPS;
+// Longest stretch of real time simulated in one frame, past this the game slows down instead of stalling
+const double MAX_FRAME_SECONDS = 0.25;
+
+// Most of a frame's idle time given to Lua's collector
+const double MAX_GC_SECONDS = 0.002;
+
+// Levels cycled through with the L key, assets/scripts/Level1.lua .. LevelN.lua
+const int NUM_LEVELS = 2;
 
 class Game {
 	private:
 		bool isRunning;
 		bool isDebug;
-		int millisecsPreviousFrame;
+		Uint64 previousFrameCounter;
+		double tickSeconds;
+		double accumulatedSeconds;
+		double interpolationAlpha;
+		SDL_Rect previousCamera; // camera at the start of the current tick
 		SDL_Window* window;
 		SDL_Renderer* renderer;
 		SDL_Rect camera;
-		sol::state lua;
+		std::unique_ptr<sol::state> lua; // before registry, script components hold its functions
+
+		GameOptions options;
+		SDL_Surface* frameSurface; // headless render target, null when windowed
+		int frameCount;
+		int levelNumber; // 0 until the first level is loaded
+		LevelAssets levelAssets;
 
 		std::unique_ptr<Registry> registry;
 		std::unique_ptr<AssetStore> assetStore;
 		std::unique_ptr<EventBus> eventBus;
+		std::unique_ptr<ThreadPool> threadPool;
+		std::unique_ptr<TileMap> tileMap;
+		std::unique_ptr<RenderThread> renderThread;
+		std::unique_ptr<LevelStreamer> levelStreamer;
+		std::unique_ptr<LuaGarbageStepper> luaGarbageStepper;
+		std::unique_ptr<TickProfiler> tickProfiler;
+		std::unique_ptr<LevelPreloader> levelPreloader; // last, its worker uses the members above
 
 		std::vector<std::vector<int>> ReadMatrixFromFile(
 			const std::string& filename, int windowWidth, int windowHeight);
 		void CreateTileMapEntities(std::vector<std::vector<int>>& matrix);
+		bool CreateHeadlessRenderer();
+		void DumpFrame();
+		void AddSystems(Registry& levelRegistry);
+		void SetupLua(sol::state& levelLua, Registry& levelRegistry);
+		void PreloadLevel(int level);
 
 	public:
-		Game();
+		Game(const GameOptions& options = GameOptions());
 		~Game();
 		void Initialize();
 		void Setup();
 		void LoadLevel(int level);
 		void Run();
+		void Simulate();
 		void ProcessInput();
 		void Update();
+		void FixedUpdate(double dt);
 		void Render();
 		void Destroy();
 
@@ -0,0 +1,91 @@
+#include "GameOptions.h"
+#include "../Logger/Logger.h"
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+
+GameOptions GameOptions::Parse(int argc, char* argv[]) {
+	GameOptions options;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (arg == "--headless") {
+			options.isHeadless = true;
+		} else if (arg == "--no-render-thread") {
+			options.isRenderThreaded = false;
+		} else if (arg == "--no-preload") {
+			options.isPreloading = false;
+		} else if (arg == "--tick-rate" && hasValue) {
+			const int tickRate = std::atoi(argv[++i]);
+			if (tickRate > 0) {
+				options.tickRate = tickRate;
+			} else {
+				Logger::Err("Invalid --tick-rate " + std::string(argv[i]));
+			}
+		} else if (arg == "--level" && hasValue) {
+			const int level = std::atoi(argv[++i]);
+			if (level > 0) {
+				options.startLevel = level;
+			} else {
+				Logger::Err("Invalid --level " + std::string(argv[i]));
+			}
+		} else if (arg == "--texture-budget" && hasValue) {
+			const int megabytes = std::atoi(argv[++i]);
+			if (megabytes >= 0) {
+				options.textureBudgetMegabytes = megabytes;
+			} else {
+				Logger::Err("Invalid --texture-budget " + std::string(argv[i]));
+			}
+		} else if (arg == "--script-budget" && hasValue) {
+			const double ms = std::atof(argv[++i]);
+			if (ms >= 0.0) {
+				options.scriptBudgetMs = ms;
+			} else {
+				Logger::Err("Invalid --script-budget " + std::string(argv[i]));
+			}
+		} else if (arg == "--size" && hasValue) {
+			int width = 0;
+			int height = 0;
+			if (std::sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+				options.headlessWidth = width;
+				options.headlessHeight = height;
+			} else {
+				Logger::Err("Invalid --size, expected WxH: " + std::string(argv[i]));
+			}
+		} else if (arg == "--simulate" && hasValue) {
+			const int ticks = std::atoi(argv[++i]);
+			if (ticks > 0) {
+				options.simulateTicks = ticks;
+			} else {
+				Logger::Err("Invalid --simulate " + std::string(argv[i]));
+			}
+		} else if (arg == "--frames" && hasValue) {
+			options.maxFrames = std::max(0, std::atoi(argv[++i]));
+		} else if (arg == "--dump-frames" && hasValue) {
+			options.frameDumpDir = argv[++i];
+		} else if (arg == "--dump-format" && hasValue) {
+			const std::string format = argv[++i];
+			if (format == "raw") {
+				options.frameDumpFormat = FRAME_DUMP_RAW;
+			} else if (format == "png") {
+				options.frameDumpFormat = FRAME_DUMP_PNG;
+			} else {
+				Logger::Err("Unknown --dump-format " + format + ", using png");
+			}
+		} else {
+			Logger::Err("Unknown option " + arg);
+		}
+	}
+
+	if (options.simulateTicks > 0) {
+		// only the level being simulated, nothing loading next to it
+		options.isHeadless = true;
+		options.isPreloading = false;
+	}
+	if (!options.frameDumpDir.empty() && !options.isHeadless) {
+		Logger::Err("--dump-frames only applies to --headless, ignoring");
+		options.frameDumpDir.clear();
+	}
+	return options;
+}
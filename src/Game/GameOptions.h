@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+enum FrameDumpFormat {
+	FRAME_DUMP_PNG,
+	FRAME_DUMP_RAW	// ARGB8888 rows with no padding, width * height * 4 bytes
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// GameOptions
+////////////////////////////////////////////////////////////////////////////////
+// Command line switches. Headless mode renders into an offscreen software
+// surface with no window and no vsync, for benchmarking and image diffs on
+// machines without a display or GPU.
+//
+//   --headless              no window, software renderer
+//   --size WxH              headless surface size (default 1280x720)
+//   --frames N              quit after N frames (0 = run until quit)
+//   --dump-frames DIR       write each rendered frame to DIR
+//   --dump-format png|raw   frame dump format (default png)
+//   --no-render-thread      draw frames on the main thread
+//   --tick-rate HZ          simulation ticks per second (default 60)
+//   --level N               level to start in (default 1)
+//   --texture-budget MB     texture memory kept for unused assets (default 256)
+//   --no-preload            load levels when switching instead of in the background
+//   --script-budget MS      entity script time per tick before the rest wait (default 4, 0 = no limit)
+//   --simulate N            run N ticks as fast as possible with nothing drawn, then log
+//                           ticks per second and per system timings (implies --headless)
+////////////////////////////////////////////////////////////////////////////////
+struct GameOptions {
+	bool isHeadless = false;
+	int headlessWidth = 1280;
+	int headlessHeight = 720;
+	int maxFrames = 0;
+	std::string frameDumpDir;
+	FrameDumpFormat frameDumpFormat = FRAME_DUMP_PNG;
+	bool isRenderThreaded = true;
+	int tickRate = 60;
+	int startLevel = 1;
+	int textureBudgetMegabytes = 256;
+	bool isPreloading = true;
+	double scriptBudgetMs = 4.0;
+	int simulateTicks = 0; // 0 = play normally
+
+	static GameOptions Parse(int argc, char* argv[]);
+};
@@ -0,0 +1,262 @@
+#include "LevelCompiler.h"
+#include "LevelComponentTypes.h"
+#include "LuaCompat.h"
+#include "../Logger/Logger.h"
+#include "../TileMap/TileMapReader.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+	int AppendChunk(lua_State*, const void* bytes, size_t size, void* chunk) {
+		static_cast<std::string*>(chunk)->append(static_cast<const char*>(bytes), size);
+		return 0;
+	}
+
+	// Component reads add their strings and scripts to the level through this
+	class ContentReader: public LevelComponentReader {
+		private:
+			CompiledLevel& level;
+			std::vector<std::string>& strings;
+			std::unordered_map<std::string, int32_t> indices;
+			std::unordered_map<const void*, int32_t> scriptIndices; // function -> script
+
+		public:
+			ContentReader(CompiledLevel& level): level(level), strings(level.strings) {
+				for (size_t i = 0; i < strings.size(); i++) {
+					indices.emplace(strings[i], i);
+				}
+			}
+
+			int32_t AddString(const std::string& value) override {
+				return Add(value);
+			}
+
+			// Kept live for this run and dumped as a chunk for the level file
+			int32_t AddScript(const sol::function& func) override {
+				auto existing = scriptIndices.find(func.pointer());
+				if (existing != scriptIndices.end()) {
+					return existing->second;
+				}
+				level.scriptFunctions.push_back(func);
+				level.scriptChunks.push_back(LevelCompiler::DumpFunction(func));
+				scriptIndices.emplace(func.pointer(), level.scriptFunctions.size() - 1);
+				return level.scriptFunctions.size() - 1;
+			}
+
+			int32_t Add(const std::string& value) {
+				auto existing = indices.find(value);
+				if (existing != indices.end()) {
+					return existing->second;
+				}
+				strings.push_back(value);
+				indices.emplace(value, strings.size() - 1);
+				return strings.size() - 1;
+			}
+	};
+}
+
+// Captured locals can't be dumped. _ENV is the exception, loading a chunk
+// points it at the globals again
+std::string LevelCompiler::DumpFunction(const sol::function& function) {
+	lua_State* L = function.lua_state();
+	function.push();
+	for (int n = 1; const char* name = lua_getupvalue(L, -1, n); n++) {
+		lua_pop(L, 1);
+		if (std::strcmp(name, "_ENV") != 0) {
+			lua_pop(L, 1);
+			Logger::Err(std::string("Level script captures local ") + name + ", it cannot be precompiled");
+			return "";
+		}
+	}
+	std::string chunk;
+	LuaCompat::Dump(L, AppendChunk, &chunk);
+	lua_pop(L, 1);
+	return chunk;
+}
+
+std::string LevelCompiler::GetLuaVersion(sol::state& lua) {
+	std::string version = lua["_VERSION"].get_or(std::string("unknown"));
+	sol::optional<sol::table> jit = lua["jit"];
+	if (jit != sol::nullopt) {
+		version += " " + jit->get_or("version", std::string("jit"));
+	}
+	return version;
+}
+
+bool LevelCompiler::RunScript(sol::state& lua, const std::string& scriptPath, CompiledLevel& level) {
+	// load without executing, validate script
+	sol::load_result script = lua.load_file(scriptPath);
+	if (!script.valid()) {
+		sol::error err = script;
+		std::string errorMessage = err.what();
+		Logger::Err("Error loading the lua script: " + errorMessage);
+		return false;
+	}
+
+	// Globals from before the script ran are the engine's, new ones belong to the level
+	std::unordered_set<std::string> engineGlobals;
+	lua.globals().for_each([&engineGlobals](const sol::object& key, const sol::object&) {
+		if (key.is<std::string>()) {
+			engineGlobals.insert(key.as<std::string>());
+		}
+	});
+
+	// Execute script
+	lua.script_file(scriptPath);
+
+	level = CompiledLevel();
+	level.sourceHash = CompiledLevel::HashFile(scriptPath);
+	level.luaVersion = GetLuaVersion(lua);
+
+	lua.globals().for_each([&level, &engineGlobals](const sol::object& key, const sol::object& value) {
+		if (!key.is<std::string>()) {
+			return;
+		}
+		const std::string name = key.as<std::string>();
+		if (name == "Level" || engineGlobals.count(name)) {
+			return;
+		}
+		const sol::type type = value.get_type();
+		if (type == sol::type::number) {
+			level.globals.push_back({ name, type, value.as<double>(), "" });
+		} else if (type == sol::type::string) {
+			level.globals.push_back({ name, type, 0.0, value.as<std::string>() });
+		} else if (type == sol::type::boolean) {
+			level.globals.push_back({ name, type, value.as<bool>() ? 1.0 : 0.0, "" });
+		}
+	});
+	std::sort(level.globals.begin(), level.globals.end(), [](const LevelGlobal& a, const LevelGlobal& b) {
+		return a.name < b.name;
+	});
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Read level assets
+	/////////////////////////////////////////////////////////////////////////////
+	sol::table assets = lua["Level"]["assets"];
+	for (int i = 0; ; i++) {
+		sol::optional<sol::table> hasAsset = assets[i];
+		if (hasAsset == sol::nullopt) {
+			break;
+		}
+
+		sol::table asset = *hasAsset;
+		std::string assetType = asset["type"];
+		if (assetType == "texture") {
+			level.textureAssets.push_back({ asset["id"].get<std::string>(), asset["file"].get<std::string>() });
+		} else if (assetType == "font") {
+			level.fontAssets.push_back({ asset["id"].get<std::string>(), asset["file"].get<std::string>(), asset["font_size"].get<int>() });
+		}
+	}
+	return true;
+}
+
+void LevelCompiler::ReadContent(sol::state& lua, CompiledLevel& level) {
+	sol::table levelTable = lua["Level"];
+	ContentReader reader(level);
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Read level tilemap information
+	/////////////////////////////////////////////////////////////////////////////
+	sol::table map = levelTable["tilemap"];
+	level.mapFile = reader.Add(map["map_file"].get<std::string>());
+	level.mapTextureAssetId = reader.Add(map["texture_asset_id"].get<std::string>());
+	level.mapNumRows = map["num_rows"];
+	level.mapNumCols = map["num_cols"];
+	level.tileSize = map["tile_size"];
+	level.mapScale = map["scale"];
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Read entities, each table is looked up once
+	/////////////////////////////////////////////////////////////////////////////
+	const LevelComponentTypes& componentTypes = LevelComponentTypes::Get();
+	std::vector<sol::table> componentTables(32); // [bit index] this entity's table
+	std::unordered_set<std::string> unknownComponents;
+	sol::table entities = levelTable["entities"];
+	for (int i = 0; ; i++) {
+		sol::optional<sol::table> hasEntity = entities[i];
+		if (hasEntity == sol::nullopt) {
+			break;
+		}
+		sol::table entity = *hasEntity;
+
+		LevelEntityRecord record = { 0, -1, -1, static_cast<uint32_t>(level.componentData.size()) };
+		sol::optional<std::string> tag = entity["tag"];
+		if (tag != sol::nullopt) {
+			record.tag = reader.Add(*tag);
+		}
+		sol::optional<std::string> group = entity["group"];
+		if (group != sol::nullopt) {
+			record.group = reader.Add(*group);
+		}
+
+		sol::optional<sol::table> hasComponents = entity["components"];
+		if (hasComponents == sol::nullopt) {
+			level.entities.push_back(record);
+			continue;
+		}
+		sol::table components = *hasComponents;
+
+		// One pass over the components the entity has, each dispatched by name
+		uint32_t present = 0;
+		components.for_each([&](const sol::object& key, const sol::object& value) {
+			const std::string name = key.is<std::string>() ? key.as<std::string>() : "";
+			const LevelComponentType* type = componentTypes.Find(name);
+			if (!type) {
+				if (unknownComponents.insert(name).second) {
+					Logger::Err("Unknown level component " + name + ", ignored");
+				}
+				return;
+			}
+			if (value.get_type() != sol::type::table) {
+				Logger::Err("Level component " + name + " is not a table");
+				return;
+			}
+			present |= type->bit;
+			componentTables[LevelComponentTypes::GetBitIndex(type->bit)] = value.as<sol::table>();
+		});
+
+		// records still go in LevelComponentBits order, whatever order the script has
+		record.components = present;
+		componentTypes.ForEachType(present, [&](const LevelComponentType& type, size_t) {
+			const size_t offset = level.componentData.size();
+			level.componentData.resize(offset + type.recordSize);
+			type.read(componentTables[LevelComponentTypes::GetBitIndex(type.bit)], level.componentData.data() + offset, reader);
+		});
+
+		level.entities.push_back(record);
+	}
+}
+
+bool LevelCompiler::Compile(sol::state& lua, const std::string& scriptPath, CompiledLevel& level) {
+	if (!RunScript(lua, scriptPath, level)) {
+		return false;
+	}
+	ReadContent(lua, level);
+	return true;
+}
+
+void LevelCompiler::ReadMapTiles(const AssetPack* pack, CompiledLevel& level) {
+	int numRows = level.mapNumRows;
+	int numCols = level.mapNumCols;
+	std::vector<uint16_t>& tiles = level.mapTiles;
+	// flat row-major grid of srcImage indices
+	tiles.assign(numRows * numCols, 0);
+	if (level.mapFile < 0 || level.mapFile >= static_cast<int32_t>(level.strings.size())) {
+		Logger::Err("Level has no map file");
+		return;
+	}
+	const std::string& mapFilePath = level.strings[level.mapFile];
+
+	// the asset pack already holds the grid, parsed offline
+	const AssetPackEntry* mapEntry = pack ? pack->Find(mapFilePath, ASSET_PACK_TILEMAP) : nullptr;
+	if (mapEntry && pack->ReadTileMap(*mapEntry, numRows, numCols, tiles)) {
+		return;
+	}
+
+	TileMapReader reader;
+	if (!reader.Read(mapFilePath, numRows, numCols, tiles)) {
+		Logger::Err(reader.GetError());
+	}
+}
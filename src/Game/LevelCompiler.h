@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CompiledLevel.h"
+#include "../AssetStore/AssetPack.h"
+#include <sol/sol.hpp>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// LevelCompiler
+////////////////////////////////////////////////////////////////////////////////
+// Turns a Level script into a CompiledLevel. The table walk happens once here,
+// everything after works on plain records. In two steps so the loader can
+// start on the assets while the rest of the table is read.
+////////////////////////////////////////////////////////////////////////////////
+class LevelCompiler {
+	public:
+		// Runs the script and reads its asset list and the globals it sets.
+		// The globals are only complete when run in a fresh state (levelc).
+		static bool RunScript(sol::state& lua, const std::string& scriptPath, CompiledLevel& level);
+		// Reads the tilemap description and entities from the Level table the script left behind
+		static void ReadContent(sol::state& lua, CompiledLevel& level);
+		static bool Compile(sol::state& lua, const std::string& scriptPath, CompiledLevel& level);
+
+		// Fills level.mapTiles from its map file: the pack's pre-parsed grid when
+		// it has one, the .map CSV otherwise. Runs on every load, compiled or not
+		static void ReadMapTiles(const AssetPack* pack, CompiledLevel& level);
+
+		// Precompiled chunks only load into the Lua they were made with
+		static std::string GetLuaVersion(sol::state& lua);
+		// Empty when the function captures locals, those would come back nil after a reload
+		static std::string DumpFunction(const sol::function& function);
+};
@@ -0,0 +1,356 @@
+#include "LevelComponentTypes.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/AnimationComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/CameraFollowComponent.h"
+#include "../Components/KeyboardControlComponent.h"
+#include "../Components/ProjectileEmitterComponent.h"
+#include "../Components/HealthComponent.h"
+#include "../Components/ScriptComponent.h"
+#include "../Components/CoroutineScriptComponent.h"
+#include "../Logger/Logger.h"
+#include <cstring>
+
+LevelComponentType::LevelComponentType(const std::string& name, LevelComponentBits bit, size_t recordSize): name(name), bit(bit), recordSize(recordSize) {
+
+}
+
+LevelComponentType& LevelComponentType::AddField(const std::string& table, const std::string& key, LevelFieldType type, size_t offset, double defaultValue, bool isRequired, double scale) {
+	fields.push_back({ table, key, type, offset, defaultValue, scale, isRequired });
+	return *this;
+}
+
+void LevelComponentType::ReadFields(const sol::table& component, uint8_t* record, LevelComponentReader& reader) const {
+	// fields of the same nested table are next to each other, it's looked up once
+	const std::string* nestedName = nullptr;
+	sol::optional<sol::table> nested;
+
+	for (const auto& field: fields) {
+		sol::object value;
+		if (field.table.empty()) {
+			value = component[field.key];
+		} else {
+			if (!nestedName || *nestedName != field.table) {
+				nested = component[field.table];
+				nestedName = &field.table;
+			}
+			if (nested != sol::nullopt) {
+				value = (*nested)[field.key];
+			}
+		}
+
+		const sol::type type = value.valid() ? value.get_type() : sol::type::lua_nil;
+		auto GetPath = [&field]() {
+			return field.table.empty() ? field.key : field.table + "." + field.key;
+		};
+		if (type == sol::type::lua_nil && field.isRequired) {
+			Logger::Err("Level component " + name + " is missing " + GetPath());
+		}
+
+		uint8_t* destination = record + field.offset;
+		if (field.type == LEVEL_FIELD_STRING) {
+			int32_t index = -1;
+			if (type == sol::type::string) {
+				index = reader.AddString(value.as<std::string>());
+			} else if (type != sol::type::lua_nil) {
+				Logger::Err("Level component " + name + " " + GetPath() + " is not a string");
+			}
+			std::memcpy(destination, &index, sizeof(index));
+			continue;
+		}
+
+		double number = field.defaultValue;
+		if (field.type == LEVEL_FIELD_BOOL && type == sol::type::boolean) {
+			number = value.as<bool>() ? 1.0 : 0.0;
+		} else if (field.type == LEVEL_FIELD_INT && field.scale != 1.0 && type == sol::type::number) {
+			// whole script units, read as int like the hand written loader did,
+			// so a fractional repeat_frequency gives the same ms as it always has
+			number = value.as<int>() * field.scale;
+		} else if (field.type != LEVEL_FIELD_BOOL && type == sol::type::number) {
+			number = value.as<double>() * field.scale;
+		} else if (type != sol::type::lua_nil) {
+			Logger::Err("Level component " + name + " " + GetPath() + " has the wrong type");
+		}
+
+		if (field.type == LEVEL_FIELD_FLOAT) {
+			const float converted = static_cast<float>(number);
+			std::memcpy(destination, &converted, sizeof(converted));
+		} else if (field.type == LEVEL_FIELD_DOUBLE) {
+			std::memcpy(destination, &number, sizeof(number));
+		} else {
+			const int32_t converted = static_cast<int32_t>(number);
+			std::memcpy(destination, &converted, sizeof(converted));
+		}
+	}
+}
+
+LevelComponentTypes::LevelComponentTypes() {
+	RegisterBuiltins();
+}
+
+LevelComponentTypes& LevelComponentTypes::Get() {
+	static LevelComponentTypes componentTypes;
+	return componentTypes;
+}
+
+int LevelComponentTypes::GetBitIndex(uint32_t bit) {
+	for (int bitIndex = 0; bitIndex < 32; bitIndex++) {
+		if (bit == (1u << bitIndex)) {
+			return bitIndex;
+		}
+	}
+	return -1;
+}
+
+void LevelComponentTypes::Register(LevelComponentType type) {
+	const int bitIndex = GetBitIndex(type.bit);
+	if (bitIndex < 0) {
+		Logger::Err("Level component " + type.name + " needs a single LevelComponentBits bit");
+		return;
+	}
+	if (byName.count(type.name) || byBit[bitIndex]) {
+		Logger::Err("Level component " + type.name + " registered twice");
+		return;
+	}
+	types.push_back(std::make_unique<LevelComponentType>(std::move(type)));
+	LevelComponentType* registered = types.back().get();
+	if (!registered->read) {
+		registered->read = [registered](const sol::table& component, uint8_t* record, LevelComponentReader& reader) {
+			registered->ReadFields(component, record, reader);
+		};
+	}
+	byName[registered->name] = registered;
+	byBit[bitIndex] = registered;
+	registeredBits |= registered->bit;
+}
+
+const LevelComponentType* LevelComponentTypes::Find(const std::string& name) const {
+	auto type = byName.find(name);
+	return type != byName.end() ? type->second : nullptr;
+}
+
+const LevelComponentType* LevelComponentTypes::Find(LevelComponentBits bit) const {
+	const int bitIndex = GetBitIndex(bit);
+	return bitIndex >= 0 ? byBit[bitIndex] : nullptr;
+}
+
+// The components Level scripts have used so far, with the same defaults the
+// old hand written reads had
+void LevelComponentTypes::RegisterBuiltins() {
+	LevelComponentType transform("transform", LEVEL_TRANSFORM, sizeof(TransformRecord));
+	transform
+		.Field("position", "x", &TransformRecord::x, 0.0, true)
+		.Field("position", "y", &TransformRecord::y, 0.0, true)
+		.Field("scale", "x", &TransformRecord::scaleX, 1.0)
+		.Field("scale", "y", &TransformRecord::scaleY, 1.0)
+		.Field("", "rotation", &TransformRecord::rotation, 0.0)
+		.Construct<TransformRecord>([](Entity entity, const TransformRecord& record, LevelComponentSpawner&) {
+			entity.AddComponent<TransformComponent>(glm::vec2(record.x, record.y), glm::vec2(record.scaleX, record.scaleY), record.rotation);
+		})
+		.Capture<TransformRecord>([](Entity entity, TransformRecord& record, LevelComponentSpawner&) {
+			if (!entity.HasComponent<TransformComponent>()) {
+				return false;
+			}
+			const auto& transform = entity.GetComponent<TransformComponent>();
+			record = { transform.position.x, transform.position.y, transform.scale.x, transform.scale.y, transform.rotation };
+			return true;
+		});
+	Register(std::move(transform));
+
+	LevelComponentType rigidBody("rigidbody", LEVEL_RIGIDBODY, sizeof(RigidBodyRecord));
+	rigidBody
+		.Field("velocity", "x", &RigidBodyRecord::velocityX, 0.0)
+		.Field("velocity", "y", &RigidBodyRecord::velocityY, 0.0)
+		.Construct<RigidBodyRecord>([](Entity entity, const RigidBodyRecord& record, LevelComponentSpawner&) {
+			entity.AddComponent<RigidBodyComponent>(glm::vec2(record.velocityX, record.velocityY));
+		})
+		.Capture<RigidBodyRecord>([](Entity entity, RigidBodyRecord& record, LevelComponentSpawner&) {
+			if (!entity.HasComponent<RigidBodyComponent>()) {
+				return false;
+			}
+			const auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+			record = { rigidBody.velocity.x, rigidBody.velocity.y };
+			return true;
+		});
+	Register(std::move(rigidBody));
+
+	// HUD sprites stay put on screen, they never stream out
+	LevelComponentType sprite("sprite", LEVEL_SPRITE, sizeof(SpriteRecord));
+	sprite
+		.String("", "texture_asset_id", &SpriteRecord::texture)
+		.Field("", "width", &SpriteRecord::width, 0.0, true)
+		.Field("", "height", &SpriteRecord::height, 0.0, true)
+		.Field("", "z_index", &SpriteRecord::zIndex, 1.0)
+		.Flag("", "fixed", &SpriteRecord::isFixed, false)
+		.Field("", "src_rect_x", &SpriteRecord::srcRectX, 0.0)
+		.Field("", "src_rect_y", &SpriteRecord::srcRectY, 0.0)
+		.Construct<SpriteRecord>([](Entity entity, const SpriteRecord& record, LevelComponentSpawner& spawner) {
+			entity.AddComponent<SpriteComponent>(spawner.GetTexture(record.texture), record.width, record.height, record.zIndex, record.isFixed != 0, record.srcRectX, record.srcRectY);
+		})
+		.Capture<SpriteRecord>([](Entity entity, SpriteRecord& record, LevelComponentSpawner& spawner) {
+			if (!entity.HasComponent<SpriteComponent>()) {
+				return false;
+			}
+			const auto& sprite = entity.GetComponent<SpriteComponent>();
+			record = { spawner.GetTextureString(sprite.texture), sprite.width, sprite.height, sprite.zIndex, sprite.isFixed, sprite.srcRect.x, sprite.srcRect.y };
+			return true;
+		})
+		.KeepsResident<SpriteRecord>([](const SpriteRecord& record) {
+			return record.isFixed != 0;
+		});
+	Register(std::move(sprite));
+
+	LevelComponentType animation("animation", LEVEL_ANIMATION, sizeof(AnimationRecord));
+	animation
+		.Field("", "num_frames", &AnimationRecord::numFrames, 1.0)
+		.Field("", "speed_rate", &AnimationRecord::frameSpeedRate, 1.0)
+		.Construct<AnimationRecord>([](Entity entity, const AnimationRecord& record, LevelComponentSpawner&) {
+			entity.AddComponent<AnimationComponent>(record.numFrames, record.frameSpeedRate);
+		})
+		.Capture<AnimationRecord>([](Entity entity, AnimationRecord& record, LevelComponentSpawner&) {
+			if (!entity.HasComponent<AnimationComponent>()) {
+				return false;
+			}
+			const auto& animation = entity.GetComponent<AnimationComponent>();
+			record = { animation.numFrames, animation.frameSpeedRate };
+			return true;
+		});
+	Register(std::move(animation));
+
+	LevelComponentType boxCollider("boxcollider", LEVEL_BOXCOLLIDER, sizeof(BoxColliderRecord));
+	boxCollider
+		.Field("", "width", &BoxColliderRecord::width, 0.0, true)
+		.Field("", "height", &BoxColliderRecord::height, 0.0, true)
+		.Field("offset", "x", &BoxColliderRecord::offsetX, 0.0)
+		.Field("offset", "y", &BoxColliderRecord::offsetY, 0.0)
+		.Construct<BoxColliderRecord>([](Entity entity, const BoxColliderRecord& record, LevelComponentSpawner&) {
+			entity.AddComponent<BoxColliderComponent>(record.width, record.height, glm::vec2(record.offsetX, record.offsetY));
+		})
+		.Capture<BoxColliderRecord>([](Entity entity, BoxColliderRecord& record, LevelComponentSpawner&) {
+			if (!entity.HasComponent<BoxColliderComponent>()) {
+				return false;
+			}
+			const auto& boxCollider = entity.GetComponent<BoxColliderComponent>();
+			record = { boxCollider.width, boxCollider.height, boxCollider.offset.x, boxCollider.offset.y };
+			return true;
+		});
+	Register(std::move(boxCollider));
+
+	LevelComponentType health("health", LEVEL_HEALTH, sizeof(HealthRecord));
+	health
+		.Field("", "health_percentage", &HealthRecord::healthPercentage, 100.0)
+		.Construct<HealthRecord>([](Entity entity, const HealthRecord& record, LevelComponentSpawner&) {
+			entity.AddComponent<HealthComponent>(record.healthPercentage);
+		})
+		.Capture<HealthRecord>([](Entity entity, HealthRecord& record, LevelComponentSpawner&) {
+			if (!entity.HasComponent<HealthComponent>()) {
+				return false;
+			}
+			record = { entity.GetComponent<HealthComponent>().healthPercentage };
+			return true;
+		});
+	Register(std::move(health));
+
+	// durations are seconds in scripts, ms in the record
+	LevelComponentType projectileEmitter("projectile_emitter", LEVEL_PROJECTILE_EMITTER, sizeof(ProjectileEmitterRecord));
+	projectileEmitter
+		.Field("projectile_velocity", "x", &ProjectileEmitterRecord::velocityX, 0.0, true)
+		.Field("projectile_velocity", "y", &ProjectileEmitterRecord::velocityY, 0.0, true)
+		.Field("", "repeat_frequency", &ProjectileEmitterRecord::repeatFrequency, 1000.0, false, 1000.0)
+		.Field("", "projectile_duration", &ProjectileEmitterRecord::projectileDuration, 10000.0, false, 1000.0)
+		.Field("", "hit_percentage_damage", &ProjectileEmitterRecord::hitPercentDamage, 10.0)
+		.Flag("", "friendly", &ProjectileEmitterRecord::isFriendly, false)
+		.Construct<ProjectileEmitterRecord>([](Entity entity, const ProjectileEmitterRecord& record, LevelComponentSpawner&) {
+			entity.AddComponent<ProjectileEmitterComponent>(
+				glm::vec2(record.velocityX, record.velocityY),
+				record.repeatFrequency,
+				record.projectileDuration,
+				record.hitPercentDamage,
+				record.isFriendly != 0
+			);
+		})
+		.Capture<ProjectileEmitterRecord>([](Entity entity, ProjectileEmitterRecord& record, LevelComponentSpawner&) {
+			if (!entity.HasComponent<ProjectileEmitterComponent>()) {
+				return false;
+			}
+			const auto& emitter = entity.GetComponent<ProjectileEmitterComponent>();
+			record = {
+				emitter.projectileVelocity.x,
+				emitter.projectileVelocity.y,
+				emitter.repeatFrequency,
+				emitter.projectileDuration,
+				emitter.hitPercentDamage,
+				emitter.isFriendly
+			};
+			return true;
+		});
+	Register(std::move(projectileEmitter));
+
+	// No capture for the player's components, its entity stays spawned
+	LevelComponentType cameraFollow("camera_follow", LEVEL_CAMERA_FOLLOW, 0);
+	cameraFollow.construct = [](Entity entity, const uint8_t*, LevelComponentSpawner&) {
+		entity.AddComponent<CameraFollowComponent>();
+	};
+	Register(std::move(cameraFollow));
+
+	LevelComponentType keyboardControl("keyboard_controller", LEVEL_KEYBOARD_CONTROL, sizeof(KeyboardControlRecord));
+	keyboardControl
+		.Field("up_velocity", "x", &KeyboardControlRecord::upX, 0.0, true)
+		.Field("up_velocity", "y", &KeyboardControlRecord::upY, 0.0, true)
+		.Field("right_velocity", "x", &KeyboardControlRecord::rightX, 0.0, true)
+		.Field("right_velocity", "y", &KeyboardControlRecord::rightY, 0.0, true)
+		.Field("down_velocity", "x", &KeyboardControlRecord::downX, 0.0, true)
+		.Field("down_velocity", "y", &KeyboardControlRecord::downY, 0.0, true)
+		.Field("left_velocity", "x", &KeyboardControlRecord::leftX, 0.0, true)
+		.Field("left_velocity", "y", &KeyboardControlRecord::leftY, 0.0, true)
+		.Construct<KeyboardControlRecord>([](Entity entity, const KeyboardControlRecord& record, LevelComponentSpawner&) {
+			entity.AddComponent<KeyboardControlComponent>(
+				glm::vec2(record.upX, record.upY),
+				glm::vec2(record.rightX, record.rightY),
+				glm::vec2(record.downX, record.downY),
+				glm::vec2(record.leftX, record.leftY)
+			);
+		});
+	Register(std::move(keyboardControl));
+
+	// A function, not data, the reader keeps one script per distinct function
+	LevelComponentType script("on_update_script", LEVEL_SCRIPT, sizeof(ScriptRecord));
+	script.read = [](const sol::table& component, uint8_t* record, LevelComponentReader& reader) {
+		sol::function func = component[0];
+		const ScriptRecord scriptRecord = { reader.AddScript(func) };
+		std::memcpy(record, &scriptRecord, sizeof(scriptRecord));
+	};
+	script
+		.Construct<ScriptRecord>([](Entity entity, const ScriptRecord& record, LevelComponentSpawner& spawner) {
+			if (const sol::function* func = spawner.GetScript(record.script)) {
+				entity.AddComponent<ScriptComponent>(*func);
+			}
+		})
+		.Capture<ScriptRecord>([](Entity entity, ScriptRecord& record, LevelComponentSpawner& spawner) {
+			if (!entity.HasComponent<ScriptComponent>()) {
+				return false;
+			}
+			record = { spawner.GetScriptIndex(entity.GetComponent<ScriptComponent>().func) };
+			return record.script >= 0;
+		});
+	Register(std::move(script));
+
+	// Run once as a coroutine with the entity, it waits between steps. Where
+	// it is in its script can't be written back, so there's no capture and
+	// its entity stays spawned
+	LevelComponentType coroutineScript("coroutine_script", LEVEL_COROUTINE_SCRIPT, sizeof(CoroutineScriptRecord));
+	coroutineScript.read = [](const sol::table& component, uint8_t* record, LevelComponentReader& reader) {
+		sol::function func = component[0];
+		const CoroutineScriptRecord scriptRecord = { reader.AddScript(func) };
+		std::memcpy(record, &scriptRecord, sizeof(scriptRecord));
+	};
+	coroutineScript
+		.Construct<CoroutineScriptRecord>([](Entity entity, const CoroutineScriptRecord& record, LevelComponentSpawner& spawner) {
+			if (const sol::function* func = spawner.GetScript(record.script)) {
+				entity.AddComponent<CoroutineScriptComponent>(*func);
+			}
+		});
+	Register(std::move(coroutineScript));
+}
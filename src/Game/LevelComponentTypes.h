@@ -0,0 +1,190 @@
+#pragma once
+
+#include "CompiledLevel.h"
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetHandle.h"
+#include <sol/sol.hpp>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum LevelFieldType {
+	LEVEL_FIELD_FLOAT,
+	LEVEL_FIELD_DOUBLE,
+	LEVEL_FIELD_INT,
+	LEVEL_FIELD_BOOL,	// stored as int32_t
+	LEVEL_FIELD_STRING	// int32_t index into the level's string table
+};
+
+// One value of a component's Lua table and where it goes in the record
+struct LevelComponentField {
+	std::string table;	// nested table it sits in, eg "position", empty when directly in the component
+	std::string key;
+	LevelFieldType type;
+	size_t offset;
+	double defaultValue;
+	double scale;		// eg 1000 for seconds in the script, ms in the record. Int fields scale whole units
+	bool isRequired;
+};
+
+// What a component's read function gets besides its table
+class LevelComponentReader {
+	public:
+		virtual ~LevelComponentReader() = default;
+		virtual int32_t AddString(const std::string& value) = 0;
+		// Index into the level's scripts, entities sharing a function share the index
+		virtual int32_t AddScript(const sol::function& func) = 0;
+};
+
+// What construct and capture get besides the entity: the loaded level's
+// textures and scripts, by the indices its records hold
+class LevelComponentSpawner {
+	public:
+		virtual ~LevelComponentSpawner() = default;
+		virtual TextureHandle GetTexture(int32_t string) = 0;
+		virtual int32_t GetTextureString(TextureHandle texture) const = 0;	// -1 when not one of the level's
+		virtual const sol::function* GetScript(int32_t script) const = 0;	// null when out of range
+		virtual int32_t GetScriptIndex(const sol::function& func) const = 0;	// -1 when not one of the level's
+};
+
+// A component as a Level script writes it and as it lives on an entity. Most
+// are read through their fields alone, the rest (eg scripts) set their own
+// read function. construct turns the record into the component, capture
+// writes a live one back (false when the entity doesn't have it). Entities
+// with a component that has no capture stay spawned, keepsResident adds the
+// ones that depend on the record (eg HUD sprites).
+struct LevelComponentType {
+	std::string name;		// key in an entity's components table
+	LevelComponentBits bit;
+	size_t recordSize;		// 0 for components with no record, eg camera_follow
+	std::vector<LevelComponentField> fields;
+	std::function<void(const sol::table& component, uint8_t* record, LevelComponentReader& reader)> read;
+	std::function<void(Entity entity, const uint8_t* record, LevelComponentSpawner& spawner)> construct;
+	std::function<bool(Entity entity, uint8_t* record, LevelComponentSpawner& spawner)> capture;
+	std::function<bool(const uint8_t* record)> keepsResident;
+
+	LevelComponentType(const std::string& name, LevelComponentBits bit, size_t recordSize);
+
+	// Typed construct / capture / keepsResident, the record is copied in and out
+	template <typename TRecord>
+	LevelComponentType& Construct(std::function<void(Entity entity, const TRecord& record, LevelComponentSpawner& spawner)> construct) {
+		this->construct = [construct](Entity entity, const uint8_t* bytes, LevelComponentSpawner& spawner) {
+			TRecord record;
+			std::memcpy(&record, bytes, sizeof(TRecord));
+			construct(entity, record, spawner);
+		};
+		return *this;
+	}
+	template <typename TRecord>
+	LevelComponentType& Capture(std::function<bool(Entity entity, TRecord& record, LevelComponentSpawner& spawner)> capture) {
+		this->capture = [capture](Entity entity, uint8_t* bytes, LevelComponentSpawner& spawner) {
+			TRecord record = {};
+			if (!capture(entity, record, spawner)) {
+				return false;
+			}
+			std::memcpy(bytes, &record, sizeof(TRecord));
+			return true;
+		};
+		return *this;
+	}
+	template <typename TRecord>
+	LevelComponentType& KeepsResident(std::function<bool(const TRecord& record)> keepsResident) {
+		this->keepsResident = [keepsResident](const uint8_t* bytes) {
+			TRecord record;
+			std::memcpy(&record, bytes, sizeof(TRecord));
+			return keepsResident(record);
+		};
+		return *this;
+	}
+
+	// Adds a field, its type and offset worked out from the record member
+	template <typename TRecord, typename TField>
+	LevelComponentType& Field(const std::string& table, const std::string& key, TField TRecord::* member, double defaultValue, bool isRequired = false, double scale = 1.0) {
+		return AddField(table, key, GetFieldType<TField>(), GetOffset(member), defaultValue, isRequired, scale);
+	}
+	template <typename TRecord>
+	LevelComponentType& Flag(const std::string& table, const std::string& key, int32_t TRecord::* member, bool defaultValue) {
+		return AddField(table, key, LEVEL_FIELD_BOOL, GetOffset(member), defaultValue ? 1.0 : 0.0, false, 1.0);
+	}
+	template <typename TRecord>
+	LevelComponentType& String(const std::string& table, const std::string& key, int32_t TRecord::* member, bool isRequired = true) {
+		return AddField(table, key, LEVEL_FIELD_STRING, GetOffset(member), -1.0, isRequired, 1.0);
+	}
+
+	// Reads the fields into record, recordSize bytes, logging the missing required ones
+	void ReadFields(const sol::table& component, uint8_t* record, LevelComponentReader& reader) const;
+
+	private:
+		LevelComponentType& AddField(const std::string& table, const std::string& key, LevelFieldType type, size_t offset, double defaultValue, bool isRequired, double scale);
+
+		template <typename TField>
+		static LevelFieldType GetFieldType() {
+			static_assert(std::is_same<TField, float>::value || std::is_same<TField, double>::value || std::is_same<TField, int32_t>::value, "Level record fields are float, double or int32_t");
+			return std::is_same<TField, float>::value ? LEVEL_FIELD_FLOAT : std::is_same<TField, double>::value ? LEVEL_FIELD_DOUBLE : LEVEL_FIELD_INT;
+		}
+		template <typename TRecord, typename TField>
+		static size_t GetOffset(TField TRecord::* member) {
+			const TRecord record = {};
+			return reinterpret_cast<const uint8_t*>(&(record.*member)) - reinterpret_cast<const uint8_t*>(&record);
+		}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// LevelComponentTypes
+////////////////////////////////////////////////////////////////////////////////
+// The components a Level script can give an entity, by name and by bit. The
+// compiler walks an entity's components table once and looks each key up
+// here, and the streamer spawns, stores and captures entities by walking the
+// types they have in bit order. So a new component only has to register its
+// type (and a bit and record in CompiledLevel.h) to be read from levels and
+// streamed.
+////////////////////////////////////////////////////////////////////////////////
+class LevelComponentTypes {
+	private:
+		std::vector<std::unique_ptr<LevelComponentType>> types;
+		std::unordered_map<std::string, const LevelComponentType*> byName;
+		const LevelComponentType* byBit[32] = {};
+		uint32_t registeredBits = 0;
+
+		LevelComponentTypes();
+		void RegisterBuiltins();
+
+	public:
+		static LevelComponentTypes& Get();
+
+		// Types registered after the first level was read are only used by later ones
+		void Register(LevelComponentType type);
+
+		const LevelComponentType* Find(const std::string& name) const;
+		const LevelComponentType* Find(LevelComponentBits bit) const;
+		uint32_t GetRegisteredBits() const { return registeredBits; }
+
+		// Calls visit(type, offset) for each type in components in bit order,
+		// offset being where its record starts among them. False, having
+		// stopped there, at a bit with no registered type: its record size and
+		// so everything after it is unknown
+		template <typename TVisit>
+		bool ForEachType(uint32_t components, TVisit visit) const {
+			size_t offset = 0;
+			for (int bitIndex = 0; components != 0; bitIndex++) {
+				const uint32_t bit = 1u << bitIndex;
+				if (!(components & bit)) {
+					continue;
+				}
+				components &= ~bit;
+				const LevelComponentType* type = byBit[bitIndex];
+				if (!type) {
+					return false;
+				}
+				visit(*type, offset);
+				offset += type->recordSize;
+			}
+			return true;
+		}
+
+		// 0 for 1 << 0 and so on, -1 unless exactly one bit is set
+		static int GetBitIndex(uint32_t bit);
+};
@@ -3,11 +3,28 @@
 #include <SDL2/SDL.h>
 #include "../ECS/ECS.h"
 #include "../AssetStore/AssetStore.h"
+#include "../TileMap/TileMap.h"
+#include "../Renderer/RenderThread.h"
+#include "../ThreadPool/ThreadPool.h"
+#include "CompiledLevel.h"
+#include "LevelStreamer.h"
 #include <memory>
 
 class LevelLoader {
+	private:
+		// Turns the precompiled script chunks back into functions and sets the level's globals
+		static bool LoadScripts(sol::state& lua, CompiledLevel& level);
+
 	public:
 		LevelLoader();
 		~LevelLoader();
-		void LoadLevel(sol::state& lua, const std::unique_ptr<Registry>& registry, const std::unique_ptr<AssetStore>& assetStore, SDL_Renderer* renderer,int level);
+		// Returns the assets the level holds a reference on
+		LevelAssets LoadLevel(sol::state& lua, const std::unique_ptr<Registry>& registry, const std::unique_ptr<AssetStore>& assetStore, const std::unique_ptr<TileMap>& tileMap, RenderThread& renderThread, ThreadPool& threadPool, const std::unique_ptr<LevelStreamer>& levelStreamer, int level);
+
+		// Steps of LoadLevel that LevelPreloader runs on its own thread. ReadLevel
+		// only touches lua and level; when it ran the script (isCompiled false)
+		// LevelCompiler::ReadContent is still to do, ReadMapTiles either way
+		static bool ReadLevel(sol::state& lua, int levelNumber, CompiledLevel& level, bool& isCompiled);
+		static std::string GetMapTextureAssetId(const CompiledLevel& level);
+		static std::string GetAtlasCacheDir();
 };
\ No newline at end of file
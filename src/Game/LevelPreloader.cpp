@@ -0,0 +1,206 @@
+#include "LevelPreloader.h"
+#include "LevelLoader.h"
+#include "LevelCompiler.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+
+namespace {
+	// Without isBlocking only asks, with it waits
+	template <typename TFuture>
+	bool IsFutureReady(const TFuture& future, bool isBlocking) {
+		if (isBlocking) {
+			future.wait();
+			return true;
+		}
+		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+}
+
+LevelPreloader::LevelPreloader(ThreadPool& threadPool): threadPool(threadPool) {
+	state = PRELOAD_IDLE;
+	isUploaded = false;
+	isCancelled = false;
+	numTicks = 0;
+	longestTickMs = 0.0;
+	longestUpdateMs = 0.0;
+}
+
+LevelPreloader::~LevelPreloader() {
+	// the store may already be gone, only stop the worker
+	isCancelled = true;
+	if (worker.joinable()) {
+		if (!assetLoader && isLevelRead.get()) {
+			assetsAcquired.set_value();
+		}
+		worker.join();
+	}
+}
+
+void LevelPreloader::Start(int levelNumber, std::unique_ptr<sol::state> lua, std::unique_ptr<Registry> registry, const std::unique_ptr<AssetStore>& assetStore) {
+	if (state != PRELOAD_IDLE) {
+		Cancel(assetStore);
+	}
+	startTime = std::chrono::steady_clock::now();
+	numTicks = 0;
+	longestTickMs = 0.0;
+	longestUpdateMs = 0.0;
+	staged = PreloadedLevel();
+	staged.levelNumber = levelNumber;
+	staged.lua = std::move(lua);
+	staged.registry = std::move(registry);
+	staged.levelStreamer = std::make_unique<LevelStreamer>(threadPool);
+
+	level = CompiledLevel();
+	assetLoader.reset();
+	isUploaded = false;
+	isCancelled = false;
+	levelRead = std::promise<bool>();
+	isLevelRead = levelRead.get_future().share();
+	assetsAcquired = std::promise<void>();
+	built = std::promise<void>();
+	isBuilt = built.get_future();
+
+	state = PRELOAD_BUILDING;
+	worker = std::thread([this, &assetStore]() {
+		Build(assetStore);
+	});
+}
+
+// Worker thread. Only reads the asset store, and only once Update has taken
+// this level's assets
+void LevelPreloader::Build(const std::unique_ptr<AssetStore>& assetStore) {
+	bool isCompiled = false;
+	bool isRead = LevelLoader::ReadLevel(*staged.lua, staged.levelNumber, level, isCompiled);
+	if (isRead && !isCompiled) {
+		LevelCompiler::ReadContent(*staged.lua, level);
+	}
+	if (isRead) {
+		LevelCompiler::ReadMapTiles(assetStore->GetPack(), level);
+	}
+	levelRead.set_value(isRead);
+	if (!isRead) {
+		return;
+	}
+
+	assetsAcquired.get_future().wait();
+	if (isCancelled) {
+		built.set_value();
+		return;
+	}
+
+	staged.mapTexture = assetStore->GetTextureHandle(LevelLoader::GetMapTextureAssetId(level));
+	staged.mapNumRows = level.mapNumRows;
+	staged.mapNumCols = level.mapNumCols;
+	staged.tileSize = level.tileSize;
+	staged.mapScale = level.mapScale;
+	staged.mapTiles = std::move(level.mapTiles);
+	staged.mapTiles.resize(staged.mapNumRows * staged.mapNumCols, 0);
+
+	// same sizes TileMap works out once it gets the grid
+	const int mapWidth = staged.mapNumCols * staged.tileSize * staged.mapScale;
+	const int mapHeight = staged.mapNumRows * staged.tileSize * staged.mapScale;
+	staged.levelStreamer->Load(level, staged.registry, assetStore, mapWidth, mapHeight);
+	staged.registry->Update();
+	built.set_value();
+}
+
+void LevelPreloader::Update(const std::unique_ptr<AssetStore>& assetStore, RenderThread& renderThread, bool isBlocking) {
+	if (state != PRELOAD_BUILDING) {
+		return;
+	}
+	const auto updateStart = std::chrono::steady_clock::now();
+	auto noteUpdate = [&]() {
+		if (!isBlocking) {
+			longestUpdateMs = std::max(longestUpdateMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count());
+		}
+	};
+
+	if (!assetLoader) {
+		if (!IsFutureReady(isLevelRead, isBlocking)) {
+			noteUpdate();
+			return;
+		}
+		if (!isLevelRead.get()) {
+			worker.join();
+			state = PRELOAD_FAILED;
+			Logger::Err("Could not preload level " + std::to_string(staged.levelNumber));
+			return;
+		}
+		// acquiring adds entries to the store, the frame being drawn must not be reading it
+		renderThread.WaitIdle();
+		assetLoader = std::make_unique<AssetLoader>(threadPool);
+		staged.assets = assetLoader->Start(*assetStore, level.textureAssets, level.fontAssets);
+		assetsAcquired.set_value();
+	}
+
+	// The upload changes the store, it waits until the worker is done reading it
+	if (!IsFutureReady(isBuilt, isBlocking) || !IsFutureReady(assetLoader->GetDecodesDone(), isBlocking)) {
+		noteUpdate();
+		return;
+	}
+	worker.join();
+	if (!isUploaded) {
+		renderThread.Invoke([&]() {
+			assetLoader->Upload(renderThread.GetRenderer(), *assetStore, LevelLoader::GetAtlasCacheDir());
+		});
+		isUploaded = true;
+	}
+	assetLoader.reset();
+	state = PRELOAD_READY;
+	noteUpdate();
+
+	// a blocking finish means the level was needed before it was done, the
+	// ticks meanwhile are the ones that show whether it ever got in the way
+	const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	Logger::Log(
+		"Level " + std::to_string(staged.levelNumber) + " preloaded in " + std::to_string(buildMs) + " ms" +
+		(isBlocking ? " (finished blocking)" : "") + ", " + std::to_string(numTicks) + " ticks ran meanwhile, longest " +
+		std::to_string(longestTickMs) + " ms, longest preload step on the main thread " + std::to_string(longestUpdateMs) + " ms"
+	);
+}
+
+void LevelPreloader::AddTick(double seconds) {
+	if (state != PRELOAD_BUILDING) {
+		return;
+	}
+	numTicks++;
+	longestTickMs = std::max(longestTickMs, seconds * 1000.0);
+}
+
+PreloadState LevelPreloader::GetState() const {
+	return state;
+}
+
+int LevelPreloader::GetLevelNumber() const {
+	return state != PRELOAD_IDLE ? staged.levelNumber : 0;
+}
+
+PreloadedLevel LevelPreloader::Take() {
+	if (state != PRELOAD_READY) {
+		Logger::Err("Preloaded level taken before it was ready");
+		return PreloadedLevel();
+	}
+	state = PRELOAD_IDLE;
+	return std::move(staged);
+}
+
+void LevelPreloader::Cancel(const std::unique_ptr<AssetStore>& assetStore) {
+	if (state == PRELOAD_BUILDING) {
+		isCancelled = true;
+		// the worker may be waiting for the assets, or never got past reading
+		if (!assetLoader && isLevelRead.get()) {
+			assetsAcquired.set_value();
+		}
+		worker.join();
+		assetLoader.reset();
+	}
+	if (state != PRELOAD_IDLE) {
+		assetStore->Release(staged.assets);
+		Logger::Log("Dropped preloaded level " + std::to_string(staged.levelNumber));
+	}
+	// the streamer and registry hold functions from the Lua state, they go first
+	staged.levelStreamer.reset();
+	staged.registry.reset();
+	staged = PreloadedLevel();
+	state = PRELOAD_IDLE;
+}
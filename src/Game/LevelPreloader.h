@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CompiledLevel.h"
+#include "LevelStreamer.h"
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../AssetStore/AssetLoader.h"
+#include "../Renderer/RenderThread.h"
+#include "../ThreadPool/ThreadPool.h"
+#include <sol/sol.hpp>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+enum PreloadState {
+	PRELOAD_IDLE,
+	PRELOAD_BUILDING,
+	PRELOAD_READY,
+	PRELOAD_FAILED
+};
+
+// A level built next to the running one, everything Game swaps in to switch to it
+struct PreloadedLevel {
+	int levelNumber = 0;
+	// declared before the registry, its script components hold functions from this state
+	std::unique_ptr<sol::state> lua;
+	std::unique_ptr<Registry> registry;
+	std::unique_ptr<LevelStreamer> levelStreamer;
+	LevelAssets assets;
+
+	std::vector<uint16_t> mapTiles;
+	int mapNumRows = 0;
+	int mapNumCols = 0;
+	int tileSize = 0;
+	double mapScale = 1.0;
+	TextureHandle mapTexture;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// LevelPreloader
+////////////////////////////////////////////////////////////////////////////////
+// Builds a level in the background while another one plays, into its own Lua
+// state, Registry and LevelStreamer, with its assets taken and uploaded next
+// to the current level's. Switching to it is then a swap, no load.
+//
+// A worker thread reads the level and creates its entities. Taking the assets
+// has to happen on the main thread and the upload on the render thread, so
+// Update does those between the worker's steps:
+//   worker: read level -> main: acquire assets -> worker: create entities ->
+//   main: wait for decodes, upload -> ready
+////////////////////////////////////////////////////////////////////////////////
+class LevelPreloader {
+	private:
+		ThreadPool& threadPool;
+		PreloadState state;
+		PreloadedLevel staged;
+		std::thread worker;
+		std::chrono::steady_clock::time_point startTime;
+		// what the game did meanwhile, to show the build never held a tick up
+		int numTicks;
+		double longestTickMs;
+		double longestUpdateMs;
+
+		CompiledLevel level;
+		std::unique_ptr<AssetLoader> assetLoader;
+		bool isUploaded;
+		std::atomic<bool> isCancelled;
+
+		std::promise<bool> levelRead;
+		std::shared_future<bool> isLevelRead;
+		std::promise<void> assetsAcquired;
+		std::promise<void> built;
+		std::future<void> isBuilt;
+
+		void Build(const std::unique_ptr<AssetStore>& assetStore);
+
+	public:
+		LevelPreloader(ThreadPool& threadPool);
+		~LevelPreloader();
+		LevelPreloader(const LevelPreloader&) = delete;
+		LevelPreloader& operator=(const LevelPreloader&) = delete;
+
+		// lua comes with its bindings and libraries, registry with its systems
+		void Start(int levelNumber, std::unique_ptr<sol::state> lua, std::unique_ptr<Registry> registry, const std::unique_ptr<AssetStore>& assetStore);
+
+		// Main thread, once per frame: moves the build along without waiting
+		// for anything. With isBlocking it waits until the level is ready
+		void Update(const std::unique_ptr<AssetStore>& assetStore, RenderThread& renderThread, bool isBlocking = false);
+
+		// A fixed tick that ran while the level was being built, for the log
+		void AddTick(double seconds);
+
+		PreloadState GetState() const;
+		int GetLevelNumber() const;
+
+		// The finished level, leaves the preloader idle
+		PreloadedLevel Take();
+		// Stops the build and gives back the assets it took
+		void Cancel(const std::unique_ptr<AssetStore>& assetStore);
+};
@@ -0,0 +1,351 @@
+#include "LevelStreamer.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/StreamedComponent.h"
+#include "../Systems/StreamingSystem.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+LevelStreamer::LevelStreamer(ThreadPool& threadPool): threadPool(threadPool) {
+	assetStore = nullptr;
+	numRegionRows = 0;
+	numRegionCols = 0;
+	regionSize = 0.0;
+}
+
+LevelStreamer::~LevelStreamer() {
+	WaitForLoads();
+}
+
+void LevelStreamer::Load(CompiledLevel& level, const std::unique_ptr<Registry>& registry, const std::unique_ptr<AssetStore>& assetStore, int mapWidth, int mapHeight) {
+	Clear();
+	this->assetStore = assetStore.get();
+	strings = std::move(level.strings);
+	textures.assign(strings.size(), TextureHandle());
+	isTextureResolved.assign(strings.size(), false);
+	scriptFunctions = std::move(level.scriptFunctions);
+	for (size_t i = 0; i < scriptFunctions.size(); i++) {
+		scriptIndices.emplace(scriptFunctions[i].pointer(), i);
+	}
+
+	std::vector<EntitySpawn> spawns;
+	Decode(level.entities, level.componentData, spawns);
+
+	regionSize = LevelStreamer::REGION_TILES * level.tileSize * level.mapScale;
+	if (regionSize > 0.0 && mapWidth > 0 && mapHeight > 0) {
+		numRegionCols = static_cast<int>(std::ceil(mapWidth / regionSize));
+		numRegionRows = static_cast<int>(std::ceil(mapHeight / regionSize));
+		regions.resize(numRegionRows * numRegionCols);
+	}
+
+	std::vector<EntitySpawn> residentSpawns;
+	for (auto& spawn: spawns) {
+		TransformRecord transform;
+		if (regions.empty() || IsResident(spawn) || !spawn.GetRecord(LEVEL_TRANSFORM, transform)) {
+			residentSpawns.push_back(std::move(spawn));
+			continue;
+		}
+		Region& region = regions[GetRegionIndex(glm::vec2(transform.x, transform.y))];
+		Encode(spawn, region.entities, region.componentData);
+	}
+	std::vector<Entity> entities = registry->CreateEntities(residentSpawns.size());
+	for (size_t i = 0; i < entities.size(); i++) {
+		Spawn(entities[i], residentSpawns[i], false);
+	}
+
+	Logger::Log(
+		"Level has " + std::to_string(residentSpawns.size()) + " resident entities and " + std::to_string(spawns.size() - residentSpawns.size()) +
+		" streamed in " + std::to_string(numRegionCols) + "x" + std::to_string(numRegionRows) + " regions"
+	);
+}
+
+void LevelStreamer::Clear() {
+	WaitForLoads();
+	regions.clear();
+	loadingRegions.clear();
+	activeRegions.clear();
+	numRegionRows = 0;
+	numRegionCols = 0;
+	regionSize = 0.0;
+	assetStore = nullptr;
+	strings.clear();
+	textures.clear();
+	isTextureResolved.clear();
+	textureStrings.clear();
+	scriptFunctions.clear();
+	scriptIndices.clear();
+}
+
+int LevelStreamer::GetRegionIndex(const glm::vec2& position) const {
+	// entities off the edge of the map count as in the nearest region
+	const int col = std::clamp(static_cast<int>(std::floor(position.x / regionSize)), 0, numRegionCols - 1);
+	const int row = std::clamp(static_cast<int>(std::floor(position.y / regionSize)), 0, numRegionRows - 1);
+	return row * numRegionCols + col;
+}
+
+void LevelStreamer::GetRegionRange(const SDL_Rect& camera, int margin, int& firstRow, int& firstCol, int& lastRow, int& lastCol) const {
+	firstCol = std::clamp(static_cast<int>(std::floor(camera.x / regionSize)) - margin, 0, numRegionCols - 1);
+	firstRow = std::clamp(static_cast<int>(std::floor(camera.y / regionSize)) - margin, 0, numRegionRows - 1);
+	lastCol = std::clamp(static_cast<int>(std::floor((camera.x + camera.w) / regionSize)) + margin, 0, numRegionCols - 1);
+	lastRow = std::clamp(static_cast<int>(std::floor((camera.y + camera.h) / regionSize)) + margin, 0, numRegionRows - 1);
+}
+
+void LevelStreamer::Update(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera) {
+	if (regions.empty()) {
+		return;
+	}
+	int firstRow, firstCol, lastRow, lastCol;
+	GetRegionRange(camera, LOAD_MARGIN, firstRow, firstCol, lastRow, lastCol);
+	for (int row = firstRow; row <= lastRow; row++) {
+		for (int col = firstCol; col <= lastCol; col++) {
+			StartLoad(row * numRegionCols + col);
+		}
+	}
+
+	// Loads that finished spawn, unless the camera turned away while they ran
+	GetRegionRange(camera, UNLOAD_MARGIN, firstRow, firstCol, lastRow, lastCol);
+	auto isNearCamera = [&](int regionIndex) {
+		const int row = regionIndex / numRegionCols;
+		const int col = regionIndex % numRegionCols;
+		return row >= firstRow && row <= lastRow && col >= firstCol && col <= lastCol;
+	};
+	for (size_t i = 0; i < loadingRegions.size();) {
+		const int regionIndex = loadingRegions[i];
+		if (regions[regionIndex].load->isDecoded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			i++;
+			continue;
+		}
+		loadingRegions[i] = loadingRegions.back();
+		loadingRegions.pop_back();
+		FinishLoad(regionIndex, registry, isNearCamera(regionIndex));
+	}
+
+	for (size_t i = 0; i < activeRegions.size();) {
+		if (isNearCamera(activeRegions[i])) {
+			i++;
+			continue;
+		}
+		regions[activeRegions[i]].state = REGION_DORMANT;
+		activeRegions[i] = activeRegions.back();
+		activeRegions.pop_back();
+	}
+
+	// Whatever stands in a region that isn't live goes dormant there, which
+	// also catches entities that walked out of the live area. Ones killed this
+	// tick are gone already, capturing them would bring them back
+	for (auto entity: registry->GetSystem<StreamingSystem>().GetSystemEntities()) {
+		if (registry->IsEntityPendingKill(entity)) {
+			continue;
+		}
+		Region& region = regions[GetRegionIndex(entity.GetComponent<TransformComponent>().position)];
+		if (region.state == REGION_ACTIVE) {
+			continue;
+		}
+		Encode(Capture(entity), region.entities, region.componentData);
+		entity.Kill();
+	}
+}
+
+void LevelStreamer::LoadAround(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera) {
+	if (regions.empty()) {
+		return;
+	}
+	int firstRow, firstCol, lastRow, lastCol;
+	GetRegionRange(camera, LOAD_MARGIN, firstRow, firstCol, lastRow, lastCol);
+	for (int row = firstRow; row <= lastRow; row++) {
+		for (int col = firstCol; col <= lastCol; col++) {
+			StartLoad(row * numRegionCols + col);
+		}
+	}
+	WaitForLoads();
+	for (const int regionIndex: loadingRegions) {
+		FinishLoad(regionIndex, registry, true);
+	}
+	loadingRegions.clear();
+}
+
+// Dormant regions with entities get a decode job, empty ones are live right away
+void LevelStreamer::StartLoad(int regionIndex) {
+	Region& region = regions[regionIndex];
+	if (region.state != REGION_DORMANT) {
+		return;
+	}
+	if (region.entities.empty()) {
+		region.state = REGION_ACTIVE;
+		activeRegions.push_back(regionIndex);
+		return;
+	}
+
+	std::shared_ptr<RegionLoad> load = std::make_shared<RegionLoad>();
+	load->entities.swap(region.entities);
+	load->componentData.swap(region.componentData);
+	load->isDecoded = load->decoded.get_future().share();
+	region.load = load;
+	region.state = REGION_LOADING;
+	loadingRegions.push_back(regionIndex);
+
+	threadPool.Enqueue([this, load]() {
+		Decode(load->entities, load->componentData, load->spawns);
+		load->decoded.set_value();
+	});
+}
+
+void LevelStreamer::FinishLoad(int regionIndex, const std::unique_ptr<Registry>& registry, bool isNearCamera) {
+	Region& region = regions[regionIndex];
+	std::shared_ptr<RegionLoad> load = std::move(region.load);
+
+	// Entities may have walked in while it was loading, they are in the region's records
+	std::vector<EntitySpawn> spawns = std::move(load->spawns);
+	Decode(region.entities, region.componentData, spawns);
+	region.entities.clear();
+	region.componentData.clear();
+
+	if (!isNearCamera) {
+		for (const auto& spawn: spawns) {
+			Encode(spawn, region.entities, region.componentData);
+		}
+		region.state = REGION_DORMANT;
+		return;
+	}
+
+	std::vector<Entity> entities = registry->CreateEntities(spawns.size());
+	for (size_t i = 0; i < entities.size(); i++) {
+		Spawn(entities[i], spawns[i], true);
+	}
+	region.state = REGION_ACTIVE;
+	activeRegions.push_back(regionIndex);
+}
+
+void LevelStreamer::WaitForLoads() {
+	for (const int regionIndex: loadingRegions) {
+		regions[regionIndex].load->isDecoded.wait();
+	}
+}
+
+bool LevelStreamer::IsResident(const EntitySpawn& spawn) {
+	if (!(spawn.components & LEVEL_TRANSFORM) || spawn.tag >= 0) { // scripts look tagged ones up by tag
+		return true;
+	}
+	bool isResident = false;
+	LevelComponentTypes::Get().ForEachType(spawn.components, [&](const LevelComponentType& type, size_t offset) {
+		isResident = isResident || !type.capture || (type.keepsResident && type.keepsResident(spawn.componentData.data() + offset));
+	});
+	return isResident;
+}
+
+// Appends to spawns. Runs on pool threads, must not touch the registry or asset store
+void LevelStreamer::Decode(const std::vector<LevelEntityRecord>& entities, const std::vector<uint8_t>& componentData, std::vector<EntitySpawn>& spawns) {
+	const LevelComponentTypes& componentTypes = LevelComponentTypes::Get();
+	spawns.reserve(spawns.size() + entities.size());
+	for (const auto& record: entities) {
+		EntitySpawn spawn;
+		spawn.tag = record.tag;
+		spawn.group = record.group;
+
+		// records are in LevelComponentBits order, keep the ones before the first that's cut off
+		const size_t start = std::min<size_t>(record.dataOffset, componentData.size());
+		const size_t available = componentData.size() - start;
+		size_t size = 0;
+		const bool isKnown = componentTypes.ForEachType(record.components, [&](const LevelComponentType& type, size_t offset) {
+			if (offset == size && type.recordSize <= available - size) {
+				spawn.components |= type.bit;
+				size += type.recordSize;
+			}
+		});
+		if (!isKnown || spawn.components != record.components) {
+			Logger::Err("Level entity has truncated or unknown component data");
+		}
+		spawn.componentData.assign(componentData.begin() + start, componentData.begin() + start + size);
+		spawns.push_back(std::move(spawn));
+	}
+}
+
+void LevelStreamer::Encode(const EntitySpawn& spawn, std::vector<LevelEntityRecord>& entities, std::vector<uint8_t>& componentData) {
+	LevelEntityRecord record;
+	record.components = spawn.components;
+	record.tag = spawn.tag;
+	record.group = spawn.group;
+	record.dataOffset = componentData.size();
+	entities.push_back(record);
+	componentData.insert(componentData.end(), spawn.componentData.begin(), spawn.componentData.end());
+}
+
+void LevelStreamer::Spawn(Entity entity, const EntitySpawn& spawn, bool isStreamed) {
+	const int32_t numStrings = strings.size();
+	if (spawn.tag >= 0 && spawn.tag < numStrings) {
+		entity.Tag(strings[spawn.tag]);
+	}
+	if (spawn.group >= 0 && spawn.group < numStrings) {
+		entity.Group(strings[spawn.group]);
+	}
+
+	LevelComponentTypes::Get().ForEachType(spawn.components, [&](const LevelComponentType& type, size_t offset) {
+		if (type.construct) {
+			type.construct(entity, spawn.componentData.data() + offset, *this);
+		}
+	});
+	if (isStreamed) {
+		entity.AddComponent<StreamedComponent>(spawn.group);
+	}
+}
+
+// The dormant form of a live entity, with whatever state it has now
+EntitySpawn LevelStreamer::Capture(Entity entity) {
+	EntitySpawn spawn;
+	spawn.group = entity.GetComponent<StreamedComponent>().group;
+
+	const LevelComponentTypes& componentTypes = LevelComponentTypes::Get();
+	componentTypes.ForEachType(componentTypes.GetRegisteredBits(), [&](const LevelComponentType& type, size_t) {
+		if (!type.capture) {
+			return;
+		}
+		const size_t offset = spawn.componentData.size();
+		spawn.componentData.resize(offset + type.recordSize);
+		if (type.capture(entity, spawn.componentData.data() + offset, *this)) {
+			spawn.components |= type.bit;
+		} else {
+			spawn.componentData.resize(offset);
+		}
+	});
+	return spawn;
+}
+
+// Texture ids resolve once per distinct id, not once per entity
+TextureHandle LevelStreamer::GetTexture(int32_t string) {
+	if (!assetStore || string < 0 || string >= static_cast<int32_t>(strings.size())) {
+		return TextureHandle();
+	}
+	if (!isTextureResolved[string]) {
+		textures[string] = assetStore->GetTextureHandle(strings[string]);
+		textureStrings[textures[string].value] = string;
+		isTextureResolved[string] = true;
+	}
+	return textures[string];
+}
+
+int32_t LevelStreamer::GetTextureString(TextureHandle texture) const {
+	auto string = textureStrings.find(texture.value);
+	return string != textureStrings.end() ? string->second : -1;
+}
+
+const sol::function* LevelStreamer::GetScript(int32_t script) const {
+	return script >= 0 && script < static_cast<int32_t>(scriptFunctions.size()) ? &scriptFunctions[script] : nullptr;
+}
+
+int32_t LevelStreamer::GetScriptIndex(const sol::function& func) const {
+	auto script = scriptIndices.find(func.pointer());
+	return script != scriptIndices.end() ? script->second : -1;
+}
+
+LevelStreamingStats LevelStreamer::GetStats() const {
+	LevelStreamingStats stats;
+	stats.numRegions = regions.size();
+	stats.numActive = activeRegions.size();
+	stats.numLoading = loadingRegions.size();
+	for (const auto& region: regions) {
+		stats.numDormantEntities += region.entities.size();
+		stats.dormantBytes += region.entities.size() * sizeof(LevelEntityRecord) + region.componentData.size();
+	}
+	return stats;
+}
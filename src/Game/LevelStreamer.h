@@ -0,0 +1,147 @@
+#pragma once
+
+#include "CompiledLevel.h"
+#include "LevelComponentTypes.h"
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../ThreadPool/ThreadPool.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// One entity's component records, back to back in LevelComponentBits order as
+// in a level file, bounds checked and ready to be turned into components
+struct EntitySpawn {
+	uint32_t components = 0;
+	int32_t tag = -1;
+	int32_t group = -1;
+	std::vector<uint8_t> componentData;
+
+	// Copies out the record of a component the entity has, false when it hasn't
+	template <typename TRecord>
+	bool GetRecord(LevelComponentBits bit, TRecord& record) const {
+		bool isFound = false;
+		LevelComponentTypes::Get().ForEachType(components & (bit | (bit - 1)), [&](const LevelComponentType& type, size_t offset) {
+			if (type.bit == bit && sizeof(TRecord) <= type.recordSize && offset + sizeof(TRecord) <= componentData.size()) {
+				std::memcpy(&record, componentData.data() + offset, sizeof(TRecord));
+				isFound = true;
+			}
+		});
+		return isFound;
+	}
+};
+
+enum RegionState {
+	REGION_DORMANT,
+	REGION_LOADING,
+	REGION_ACTIVE
+};
+
+struct LevelStreamingStats {
+	int numRegions = 0;
+	int numActive = 0;
+	int numLoading = 0;
+	size_t numDormantEntities = 0;
+	size_t dormantBytes = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// LevelStreamer
+////////////////////////////////////////////////////////////////////////////////
+// Keeps a level's entities in square regions of REGION_TILES tiles. Only the
+// regions around the camera have live entities; the rest hold them dormant,
+// as the same records a compiled level uses. A region the camera approaches
+// is decoded on the thread pool and spawned by Update once that's done. When
+// the camera moves away, the entities standing in it are written back with
+// their current state and killed. Entities that wandered into another region
+// go dormant there.
+//
+// Components are spawned and captured through their LevelComponentTypes, in
+// bit order. The player, tagged entities, fixed (HUD) sprites, anything
+// without a transform and anything with a component that can't be captured
+// (eg a coroutine script) are resident and spawned with the level as before.
+////////////////////////////////////////////////////////////////////////////////
+class LevelStreamer: private LevelComponentSpawner {
+	private:
+		// A region being decoded, the job only touches this
+		struct RegionLoad {
+			std::vector<LevelEntityRecord> entities;
+			std::vector<uint8_t> componentData;
+			std::vector<EntitySpawn> spawns;
+			std::promise<void> decoded;
+			std::shared_future<void> isDecoded;
+		};
+
+		struct Region {
+			RegionState state = REGION_DORMANT;
+			std::vector<LevelEntityRecord> entities;
+			std::vector<uint8_t> componentData;
+			std::shared_ptr<RegionLoad> load;
+		};
+
+		ThreadPool& threadPool;
+		std::vector<Region> regions;
+		std::vector<int> loadingRegions;
+		std::vector<int> activeRegions;
+		int numRegionRows;
+		int numRegionCols;
+		double regionSize; // in world pixels
+
+		// From the level, only used where entities are spawned and captured
+		AssetStore* assetStore;
+		std::vector<std::string> strings;
+		std::vector<TextureHandle> textures; // [string index], resolved on first use
+		std::vector<bool> isTextureResolved;
+		std::unordered_map<uint32_t, int32_t> textureStrings; // handle value -> string index
+		std::vector<sol::function> scriptFunctions;
+		std::unordered_map<const void*, int32_t> scriptIndices; // function -> script
+
+		int GetRegionIndex(const glm::vec2& position) const;
+		// Regions overlapping the camera grown by margin regions on each side
+		void GetRegionRange(const SDL_Rect& camera, int margin, int& firstRow, int& firstCol, int& lastRow, int& lastCol) const;
+
+		void StartLoad(int regionIndex);
+		void FinishLoad(int regionIndex, const std::unique_ptr<Registry>& registry, bool isNearCamera);
+		void WaitForLoads();
+
+		static bool IsResident(const EntitySpawn& spawn);
+		static void Decode(const std::vector<LevelEntityRecord>& entities, const std::vector<uint8_t>& componentData, std::vector<EntitySpawn>& spawns);
+		static void Encode(const EntitySpawn& spawn, std::vector<LevelEntityRecord>& entities, std::vector<uint8_t>& componentData);
+		void Spawn(Entity entity, const EntitySpawn& spawn, bool isStreamed);
+		EntitySpawn Capture(Entity entity);
+
+		TextureHandle GetTexture(int32_t string) override;
+		int32_t GetTextureString(TextureHandle texture) const override;
+		const sol::function* GetScript(int32_t script) const override;
+		int32_t GetScriptIndex(const sol::function& func) const override;
+
+	public:
+		static const int REGION_TILES = 16;
+		// Regions within LOAD_MARGIN of the camera are loaded, past UNLOAD_MARGIN they go dormant
+		static const int LOAD_MARGIN = 1;
+		static const int UNLOAD_MARGIN = 2;
+
+		LevelStreamer(ThreadPool& threadPool);
+		~LevelStreamer();
+		LevelStreamer(const LevelStreamer&) = delete;
+		LevelStreamer& operator=(const LevelStreamer&) = delete;
+
+		// Takes the level's entities. Resident ones are created right away,
+		// the rest wait in their regions for the camera
+		void Load(CompiledLevel& level, const std::unique_ptr<Registry>& registry, const std::unique_ptr<AssetStore>& assetStore, int mapWidth, int mapHeight);
+		// Waits for any decodes and forgets the regions, the registry is the caller's
+		void Clear();
+
+		// Once per tick, after the camera moved. Starts loads for regions the
+		// camera is getting near, spawns finished ones and puts the ones it left
+		// to sleep
+		void Update(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera);
+		// Same, but the regions around the camera are spawned before it returns
+		void LoadAround(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera);
+
+		LevelStreamingStats GetStats() const;
+};
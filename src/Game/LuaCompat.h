@@ -0,0 +1,56 @@
+#pragma once
+
+#include <sol/sol.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+// LuaCompat
+////////////////////////////////////////////////////////////////////////////////
+// The engine runs on Lua 5.3 or, built with make LUAJIT=1, on LuaJIT (the
+// 5.1 API; sol is told with SOL_LUAJIT). What differs between the two at the
+// C API is kept here. Scripts run on both as long as they stay away from 5.3
+// only syntax: integer division, bit operators, goto.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LUA_OK
+#define LUA_OK 0
+#endif
+
+class LuaCompat {
+	public:
+		// What scripts may use, coroutine for the scheduler's wait functions. On
+		// LuaJIT the jit table is there too, which also tells compiled levels
+		// apart from the ones made for 5.3
+		static void OpenLibraries(sol::state& lua) {
+			lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::os, sol::lib::coroutine);
+#ifdef USE_LUAJIT
+			lua.open_libraries(sol::lib::jit);
+#endif
+		}
+
+		// Bytecode of the function on top of the stack, strip arrived in 5.3
+		static int Dump(lua_State* L, lua_Writer writer, void* data) {
+#if LUA_VERSION_NUM >= 503
+			return lua_dump(L, writer, data, 0);
+#else
+			return lua_dump(L, writer, data);
+#endif
+		}
+
+		// One incremental collector step as if kb had been allocated, true when it
+		// finished a cycle. LuaJIT (like 5.1) restarts a stopped collector when
+		// stepped, so it's stopped again
+		static bool StepGarbage(lua_State* L, int kb) {
+			const bool isCycleDone = lua_gc(L, LUA_GCSTEP, kb) != 0;
+#ifdef USE_LUAJIT
+			lua_gc(L, LUA_GCSTOP, 0);
+#endif
+			return isCycleDone;
+		}
+
+		static const char* GetVM() {
+#ifdef USE_LUAJIT
+			return "LuaJIT";
+#else
+			return "Lua";
+#endif
+		}
+};
@@ -0,0 +1,60 @@
+#include "LuaGarbageStepper.h"
+#include "LuaCompat.h"
+#include <algorithm>
+#include <chrono>
+
+LuaGarbageStepper::LuaGarbageStepper() {
+	L = nullptr;
+	cycleEndKb = 0;
+	stepEndKb = 0;
+}
+
+void LuaGarbageStepper::Attach(lua_State* L) {
+	this->L = L;
+	stats = LuaGarbageStats();
+	if (L) {
+		lua_gc(L, LUA_GCSTOP, 0);
+		cycleEndKb = lua_gc(L, LUA_GCCOUNT, 0);
+		stepEndKb = cycleEndKb;
+		stats.memoryKb = cycleEndKb;
+	}
+}
+
+void LuaGarbageStepper::Step(double maxSeconds) {
+	stats.numSteps = 0;
+	stats.stepMs = 0.0;
+	stats.isCatchingUp = false;
+	if (!L) {
+		return;
+	}
+
+	// The first step pays for everything allocated since the last frame, as the
+	// collector would have while running. A stopped collector doesn't keep
+	// that debt, fixed size steps alone fall behind a frame with no time left
+	int stepKb = std::max(GC_STEP_KB, lua_gc(L, LUA_GCCOUNT, 0) - stepEndKb);
+	const auto startTime = std::chrono::steady_clock::now();
+	double seconds = 0.0;
+	bool isBehind = false;
+	do {
+		stats.numSteps++;
+		const bool isCycleDone = LuaCompat::StepGarbage(L, stepKb);
+		stepKb = GC_STEP_KB;
+		if (isCycleDone) {
+			stats.numCycles++;
+			cycleEndKb = lua_gc(L, LUA_GCCOUNT, 0);
+			isBehind = false;
+			break; // nothing left to collect until more is allocated
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		isBehind = lua_gc(L, LUA_GCCOUNT, 0) > cycleEndKb * GC_PAUSE;
+		stats.isCatchingUp = stats.isCatchingUp || (isBehind && seconds >= maxSeconds);
+	} while (seconds < maxSeconds || isBehind);
+
+	stats.stepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	stats.memoryKb = lua_gc(L, LUA_GCCOUNT, 0);
+	stepEndKb = stats.memoryKb;
+}
+
+LuaGarbageStats LuaGarbageStepper::GetStats() const {
+	return stats;
+}
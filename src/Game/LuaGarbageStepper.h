@@ -0,0 +1,43 @@
+#pragma once
+
+#include <sol/sol.hpp>
+
+struct LuaGarbageStats {
+	int memoryKb = 0;
+	int numSteps = 0;		// last frame
+	double stepMs = 0.0;	// last frame
+	int numCycles = 0;		// since attached
+	bool isCatchingUp = false;	// last frame stepped past its time, memory had grown too far
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// LuaGarbageStepper
+////////////////////////////////////////////////////////////////////////////////
+// Lua's collector normally runs inside whatever allocates, so a script can
+// take a GC step's time in the middle of a tick. Once attached, the collector
+// is stopped and only runs in Step, which the game calls with the time left
+// before the next tick is due. Each frame it does at least the work for what
+// was allocated since the last one, and if memory grows past GC_PAUSE times
+// what the last cycle left it keeps going until the cycle is done, as Lua's
+// own pause would have.
+////////////////////////////////////////////////////////////////////////////////
+class LuaGarbageStepper {
+	private:
+		static const int GC_STEP_KB = 16;
+		static const int GC_PAUSE = 2;
+
+		lua_State* L;
+		int cycleEndKb;	// in use when the last cycle finished
+		int stepEndKb;	// in use when the last Step returned
+		LuaGarbageStats stats;
+
+	public:
+		LuaGarbageStepper();
+
+		// L's collector only runs in Step from now on. The state L replaces
+		// may already be gone, it isn't touched
+		void Attach(lua_State* L);
+		void Step(double maxSeconds);
+
+		LuaGarbageStats GetStats() const;
+};
@@ -0,0 +1,64 @@
+#include "TickProfiler.h"
+#include "../Logger/Logger.h"
+#include <cstdio>
+
+TickProfiler::TickProfiler() {
+	isEnabled = false;
+	numTicks = 0;
+	nextSection = 0;
+}
+
+void TickProfiler::SetEnabled(bool isEnabled) {
+	this->isEnabled = isEnabled;
+}
+
+void TickProfiler::BeginTick() {
+	if (!isEnabled) {
+		return;
+	}
+	numTicks++;
+	nextSection = 0;
+	markTime = std::chrono::steady_clock::now();
+}
+
+void TickProfiler::Mark(const char* name) {
+	if (!isEnabled) {
+		return;
+	}
+	const auto now = std::chrono::steady_clock::now();
+	const double seconds = std::chrono::duration<double>(now - markTime).count();
+	markTime = now;
+
+	// ticks mark the same steps in the same order, so it's nearly always the next one
+	size_t index = nextSection;
+	if (index >= sections.size() || sections[index].name != name) {
+		for (index = 0; index < sections.size() && sections[index].name != name; index++);
+		if (index == sections.size()) {
+			sections.push_back({ name, 0.0 });
+		}
+	}
+	sections[index].seconds += seconds;
+	nextSection = index + 1;
+}
+
+void TickProfiler::Log() const {
+	if (numTicks == 0) {
+		return;
+	}
+	double totalSeconds = 0.0;
+	for (const auto& section: sections) {
+		totalSeconds += section.seconds;
+	}
+	for (const auto& section: sections) {
+		char line[128];
+		std::snprintf(
+			line, sizeof(line), "%-26s %10.2f ms total %9.2f us/tick %5.1f%%",
+			section.name.c_str(), section.seconds * 1000.0, section.seconds * 1e6 / numTicks,
+			totalSeconds > 0.0 ? section.seconds * 100.0 / totalSeconds : 0.0
+		);
+		Logger::Log(line);
+	}
+	char line[128];
+	std::snprintf(line, sizeof(line), "%-26s %10.2f ms total %9.2f us/tick", "tick", totalSeconds * 1000.0, totalSeconds * 1e6 / numTicks);
+	Logger::Log(line);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// TickProfiler
+////////////////////////////////////////////////////////////////////////////////
+// Where a fixed tick's time goes. FixedUpdate marks the end of each step with
+// a name, the time since the previous mark is added to it. Off unless
+// enabled, a mark is then just the check.
+////////////////////////////////////////////////////////////////////////////////
+class TickProfiler {
+	private:
+		struct Section {
+			std::string name;
+			double seconds;
+		};
+
+		bool isEnabled;
+		int numTicks;
+		std::vector<Section> sections; // in the order they were first marked
+		size_t nextSection; // where this tick's next mark usually is
+		std::chrono::steady_clock::time_point markTime;
+
+	public:
+		TickProfiler();
+
+		void SetEnabled(bool isEnabled);
+		bool IsEnabled() const { return isEnabled; }
+
+		void BeginTick();
+		void Mark(const char* name);
+
+		// One line per section and one for the whole tick, total and per tick
+		void Log() const;
+};
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <chrono>
 #include <ctime>
+#include <mutex>
 
 #define ANSI_COLOR_RED "\x1b[31m"
 #define ANSI_COLOR_GREEN "\x1b[32m"
@@ -10,6 +11,9 @@
 // deine messages field
 std::vector<LogEntry> Logger::messages;
 
+// loaders and the render thread log too
+static std::mutex logMutex;
+
 std::string Logger::CurrentDateTimeToString() {
 	std::time_t now = std::chrono::system_clock::to_time_t(
 		std::chrono::system_clock::now());
@@ -19,6 +23,7 @@ std::string Logger::CurrentDateTimeToString() {
 }
 
 void Logger::Log(const std::string& message) {
+	std::lock_guard<std::mutex> lock(logMutex);
 	LogEntry logEntry;
 	logEntry.type = LOG_INFO;
 	logEntry.message = "LOG | " + CurrentDateTimeToString() + " - " + message;
@@ -29,6 +34,7 @@ void Logger::Log(const std::string& message) {
 }
 
 void Logger::Err(const std::string& message) {
+	std::lock_guard<std::mutex> lock(logMutex);
 	LogEntry logEntry;
 	logEntry.type = LOG_ERROR;
 	logEntry.message = "ERR | " + CurrentDateTimeToString() + " - " + message;
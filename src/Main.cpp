@@ -3,9 +3,14 @@
 #include <iostream>
 
 int main(int argc, char* argv[]) {
-    Game game;  // c++ constructs w/o "new", stores on stack (instead of dyn alloc/heap), destroyed at scope end.
+    const GameOptions options = GameOptions::Parse(argc, argv);
+    Game game(options);  // c++ constructs w/o "new", stores on stack (instead of dyn alloc/heap), destroyed at scope end.
     game.Initialize();
-    game.Run();
+    if (options.simulateTicks > 0) {
+        game.Simulate();
+    } else {
+        game.Run();
+    }
     game.Destroy();
     return 0;
 }
\ No newline at end of file
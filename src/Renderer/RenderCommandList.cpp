@@ -0,0 +1,101 @@
+#include "RenderCommandList.h"
+
+RenderCommandList::RenderCommandList() {
+	clearColor = { 0, 0, 0, 255 };
+	camera = { 0, 0, 0, 0 };
+	guiDrawData = ImDrawData();
+}
+
+RenderCommandList::~RenderCommandList() {
+	Reset();
+}
+
+void RenderCommandList::Reset() {
+	commands.clear();
+	sprites.clear();
+	rects.clear();
+	texts.clear();
+	textData.clear();
+	for (auto drawList: guiDrawLists) {
+		IM_DELETE(drawList);
+	}
+	guiDrawLists.clear();
+}
+
+// Extends the last command if it is a run of the same type
+void RenderCommandList::AddCommand(RenderCommandType type, uint32_t index) {
+	if (!commands.empty() && commands.back().type == type && commands.back().first + commands.back().count == index) {
+		commands.back().count++;
+		return;
+	}
+	commands.push_back({ type, index, 1 });
+}
+
+void RenderCommandList::AddClear(const SDL_Color& color) {
+	clearColor = color;
+	commands.push_back({ RENDER_CLEAR, 0, 1 });
+}
+
+void RenderCommandList::AddTileMap(const SDL_Rect& camera) {
+	this->camera = camera;
+	commands.push_back({ RENDER_TILEMAP, 0, 1 });
+}
+
+void RenderCommandList::AddSprite(const SpriteDraw& sprite) {
+	sprites.push_back(sprite);
+	AddCommand(RENDER_SPRITES, sprites.size() - 1);
+}
+
+void RenderCommandList::AddFillRect(const SDL_Rect& rect, const SDL_Color& color) {
+	rects.push_back({ rect, color });
+	AddCommand(RENDER_FILL_RECTS, rects.size() - 1);
+}
+
+void RenderCommandList::AddDrawRect(const SDL_Rect& rect, const SDL_Color& color) {
+	rects.push_back({ rect, color });
+	AddCommand(RENDER_DRAW_RECTS, rects.size() - 1);
+}
+
+void RenderCommandList::AddText(FontHandle font, const std::string& text, const SDL_Color& color, int x, int y) {
+	TextDraw draw;
+	draw.font = font;
+	draw.textOffset = textData.size();
+	draw.textLength = text.size();
+	draw.label = nullptr;
+	draw.color = color;
+	draw.x = x;
+	draw.y = y;
+	textData += text;
+	texts.push_back(draw);
+	AddCommand(RENDER_TEXTS, texts.size() - 1);
+}
+
+void RenderCommandList::AddLabel(FontHandle font, const std::string& label, const SDL_Color& color, int x, int y) {
+	TextDraw draw;
+	draw.font = font;
+	draw.textOffset = 0;
+	draw.textLength = label.size();
+	draw.label = &label;
+	draw.color = color;
+	draw.x = x;
+	draw.y = y;
+	texts.push_back(draw);
+	AddCommand(RENDER_TEXTS, texts.size() - 1);
+}
+
+void RenderCommandList::AddGui(const ImDrawData* drawData) {
+	if (!drawData || !drawData->Valid) {
+		return;
+	}
+	guiDrawData = *drawData;
+	for (int i = 0; i < drawData->CmdListsCount; i++) {
+		guiDrawLists.push_back(drawData->CmdLists[i]->CloneOutput());
+	}
+	commands.push_back({ RENDER_GUI, 0, 1 });
+}
+
+ImDrawData* RenderCommandList::GetGuiDrawData() {
+	guiDrawData.CmdLists = guiDrawLists.data();
+	guiDrawData.CmdListsCount = guiDrawLists.size();
+	return &guiDrawData;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "SpriteBatch.h"
+#include "../AssetStore/AssetHandle.h"
+#include <SDL2/SDL.h>
+#include <imgui/imgui.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum RenderCommandType {
+	RENDER_CLEAR,
+	RENDER_TILEMAP,
+	RENDER_SPRITES,
+	RENDER_FILL_RECTS,
+	RENDER_DRAW_RECTS,
+	RENDER_TEXTS,
+	RENDER_GUI
+};
+
+// A run of draws of one type, [first, first + count) in the matching array
+struct RenderCommand {
+	RenderCommandType type;
+	uint32_t first;
+	uint32_t count;
+};
+
+struct RectDraw {
+	SDL_Rect rect;
+	SDL_Color color;
+};
+
+struct TextDraw {
+	FontHandle font;
+	uint32_t textOffset;	// into the list's text data
+	uint32_t textLength;
+	const std::string* label;	// drawn instead of the text data when set
+	SDL_Color color;
+	int x;
+	int y;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// RenderCommandList
+////////////////////////////////////////////////////////////////////////////////
+// Everything needed to draw one frame, recorded by the render systems on the
+// simulation thread and replayed later by the RenderThread. Nothing in here
+// points back into the registry, so the simulation can move on as soon as a
+// frame is recorded. Consecutive draws of the same type share one command.
+// Lists are reused frame to frame, Reset keeps their capacity.
+////////////////////////////////////////////////////////////////////////////////
+class RenderCommandList {
+	private:
+		std::vector<RenderCommand> commands;
+		std::vector<SpriteDraw> sprites;
+		std::vector<RectDraw> rects;
+		std::vector<TextDraw> texts;
+		std::string textData;
+		SDL_Color clearColor;
+		SDL_Rect camera;
+
+		// ImGui output is cloned, ImGui reuses its own lists on the next NewFrame
+		ImDrawData guiDrawData;
+		std::vector<ImDrawList*> guiDrawLists;
+
+		void AddCommand(RenderCommandType type, uint32_t index);
+
+	public:
+		RenderCommandList();
+		~RenderCommandList();
+		RenderCommandList(const RenderCommandList&) = delete;
+		RenderCommandList& operator=(const RenderCommandList&) = delete;
+
+		void Reset();
+
+		void AddClear(const SDL_Color& color);
+		void AddTileMap(const SDL_Rect& camera);
+		void AddSprite(const SpriteDraw& sprite);
+		void AddFillRect(const SDL_Rect& rect, const SDL_Color& color);
+		void AddDrawRect(const SDL_Rect& rect, const SDL_Color& color);
+		void AddText(FontHandle font, const std::string& text, const SDL_Color& color, int x, int y);
+		// Like AddText without the copy, the label must outlive every frame it's
+		// drawn in and never change
+		void AddLabel(FontHandle font, const std::string& label, const SDL_Color& color, int x, int y);
+		void AddGui(const ImDrawData* drawData);
+
+		const std::vector<RenderCommand>& GetCommands() const { return commands; }
+		const std::vector<SpriteDraw>& GetSprites() const { return sprites; }
+		const std::vector<RectDraw>& GetRects() const { return rects; }
+		const std::vector<TextDraw>& GetTexts() const { return texts; }
+		const char* GetTextData() const { return textData.data(); }
+		const SDL_Color& GetClearColor() const { return clearColor; }
+		const SDL_Rect& GetCamera() const { return camera; }
+		ImDrawData* GetGuiDrawData();
+};
@@ -0,0 +1,197 @@
+#include "RenderThread.h"
+#include "../Logger/Logger.h"
+#include <imgui/imgui_sdl.h>
+
+RenderThread::RenderThread(const std::unique_ptr<AssetStore>& assetStore, const std::unique_ptr<TileMap>& tileMap, bool isThreaded):
+	assetStore(assetStore),
+	tileMap(tileMap),
+	renderer(nullptr),
+	isThreaded(isThreaded),
+	recordingFrame(nullptr),
+	isBusy(false),
+	isStopping(false),
+	busyCounter(0)
+{
+	for (auto& frame: frameBuffers) {
+		freeFrames.push_back(&frame);
+	}
+	if (isThreaded) {
+		thread = std::thread(&RenderThread::ThreadLoop, this);
+	}
+	Logger::Log(std::string("RenderThread constructor called, ") + (isThreaded ? "threaded." : "inline."));
+}
+
+RenderThread::~RenderThread() {
+	if (isThreaded) {
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			isStopping = true;
+		}
+		tasksChanged.notify_all();
+		thread.join();
+	}
+	Logger::Log("RenderThread destructor called.");
+}
+
+void RenderThread::SetRenderer(SDL_Renderer* renderer) {
+	this->renderer = renderer;
+}
+
+SDL_Renderer* RenderThread::GetRenderer() const {
+	return renderer;
+}
+
+void RenderThread::ThreadLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(tasksMutex);
+			tasksChanged.wait(lock, [this]() { return isStopping || !tasks.empty(); });
+			if (isStopping && tasks.empty()) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+			isBusy = true;
+		}
+		task();
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			isBusy = false;
+		}
+		tasksChanged.notify_all();
+	}
+}
+
+void RenderThread::PushTask(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		tasks.push_back(std::move(task));
+	}
+	tasksChanged.notify_all();
+}
+
+void RenderThread::Invoke(const std::function<void()>& task) {
+	if (!isThreaded) {
+		task();
+		return;
+	}
+	bool isDone = false;
+	PushTask([this, &task, &isDone]() {
+		task();
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		isDone = true;
+	});
+	std::unique_lock<std::mutex> lock(tasksMutex);
+	tasksChanged.wait(lock, [&isDone]() { return isDone; });
+}
+
+void RenderThread::WaitIdle() {
+	if (!isThreaded) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(tasksMutex);
+	tasksChanged.wait(lock, [this]() { return tasks.empty() && !isBusy; });
+}
+
+RenderCommandList& RenderThread::BeginFrame() {
+	{
+		// all buffers in flight, wait for the render thread to hand one back
+		std::unique_lock<std::mutex> lock(tasksMutex);
+		tasksChanged.wait(lock, [this]() { return !freeFrames.empty(); });
+		recordingFrame = freeFrames.back();
+		freeFrames.pop_back();
+	}
+	recordingFrame->Reset();
+	return *recordingFrame;
+}
+
+void RenderThread::SubmitFrame() {
+	RenderCommandList* frame = recordingFrame;
+	recordingFrame = nullptr;
+	auto task = [this, frame]() {
+		Execute(*frame);
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			freeFrames.push_back(frame);
+		}
+		tasksChanged.notify_all();
+	};
+
+	if (isThreaded) {
+		PushTask(task);
+	} else {
+		task();
+	}
+}
+
+Uint64 RenderThread::GetBusyCounter() const {
+	return busyCounter;
+}
+
+void RenderThread::Execute(RenderCommandList& frame) {
+	const Uint64 counterStart = SDL_GetPerformanceCounter();
+
+	for (const auto& command: frame.GetCommands()) {
+		const uint32_t last = command.first + command.count;
+		switch (command.type) {
+			case RENDER_CLEAR: {
+				const SDL_Color& color = frame.GetClearColor();
+				SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+				SDL_RenderClear(renderer);
+				break;
+			}
+			case RENDER_TILEMAP:
+				tileMap->Render(renderer, assetStore, frame.GetCamera());
+				break;
+			case RENDER_SPRITES: {
+				// sprites arrive sorted, one run goes through the batch
+				const auto& sprites = frame.GetSprites();
+				spriteBatch.Begin(renderer);
+				for (uint32_t i = command.first; i < last; i++) {
+					spriteBatch.Add(sprites[i]);
+				}
+				spriteBatch.Flush();
+				break;
+			}
+			case RENDER_FILL_RECTS:
+			case RENDER_DRAW_RECTS: {
+				const auto& rects = frame.GetRects();
+				for (uint32_t i = command.first; i < last; i++) {
+					const SDL_Color& color = rects[i].color;
+					SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+					if (command.type == RENDER_FILL_RECTS) {
+						SDL_RenderFillRect(renderer, &rects[i].rect);
+					} else {
+						SDL_RenderDrawRect(renderer, &rects[i].rect);
+					}
+				}
+				break;
+			}
+			case RENDER_TEXTS: {
+				const auto& texts = frame.GetTexts();
+				for (uint32_t i = command.first; i < last; i++) {
+					const TextDraw& text = texts[i];
+					// atlases are built here on first use, they need the renderer
+					const GlyphAtlas* atlas = assetStore->GetGlyphAtlas(renderer, text.font);
+					if (!atlas) {
+						continue;
+					}
+					if (text.label) {
+						textRenderer.DrawLabel(renderer, *atlas, *text.label, text.color, text.x, text.y);
+						continue;
+					}
+					scratchText.assign(frame.GetTextData() + text.textOffset, text.textLength);
+					textRenderer.DrawText(renderer, *atlas, scratchText, text.color, text.x, text.y);
+				}
+				break;
+			}
+			case RENDER_GUI:
+				ImGuiSDL::Render(frame.GetGuiDrawData());
+				break;
+		}
+	}
+
+	SDL_RenderPresent(renderer);
+	busyCounter += SDL_GetPerformanceCounter() - counterStart;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "RenderCommandList.h"
+#include "SpriteBatch.h"
+#include "TextRenderer.h"
+#include "../AssetStore/AssetStore.h"
+#include "../TileMap/TileMap.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// RenderThread
+////////////////////////////////////////////////////////////////////////////////
+// Owns the SDL_Renderer and replays recorded RenderCommandLists on its own
+// thread, so simulating frame N + 1 overlaps drawing and presenting frame N.
+// Frames are recorded into one of NUM_FRAME_BUFFERS lists; BeginFrame blocks
+// only when the render thread is that many frames behind.
+//
+// SDL renderers are not thread safe and GL contexts are bound to a thread, so
+// anything else that touches the renderer (creating it, loading textures,
+// teardown) is run on the render thread through Invoke.
+// Without threading, frames and tasks simply run on the calling thread.
+////////////////////////////////////////////////////////////////////////////////
+class RenderThread {
+	private:
+		static const int NUM_FRAME_BUFFERS = 3;
+
+		const std::unique_ptr<AssetStore>& assetStore;
+		const std::unique_ptr<TileMap>& tileMap;
+		SDL_Renderer* renderer;
+		bool isThreaded;
+
+		RenderCommandList frameBuffers[NUM_FRAME_BUFFERS];
+		std::vector<RenderCommandList*> freeFrames;
+		RenderCommandList* recordingFrame;
+
+		std::thread thread;
+		std::deque<std::function<void()>> tasks;
+		std::mutex tasksMutex;
+		std::condition_variable tasksChanged;
+		bool isBusy;
+		bool isStopping;
+
+		// Only touched on the render thread
+		SpriteBatch spriteBatch;
+		TextRenderer textRenderer;
+		std::string scratchText;
+		std::atomic<Uint64> busyCounter;
+
+		void ThreadLoop();
+		void PushTask(std::function<void()> task);
+		void Execute(RenderCommandList& frame);
+
+	public:
+		RenderThread(const std::unique_ptr<AssetStore>& assetStore, const std::unique_ptr<TileMap>& tileMap, bool isThreaded);
+		~RenderThread();
+
+		// Renderer used for replaying frames, set from inside Invoke
+		void SetRenderer(SDL_Renderer* renderer);
+		SDL_Renderer* GetRenderer() const;
+
+		// Runs task on the render thread after all queued frames, and waits for it
+		void Invoke(const std::function<void()>& task);
+		void WaitIdle();
+
+		RenderCommandList& BeginFrame();
+		void SubmitFrame();
+
+		// Performance counter ticks spent replaying frames so far
+		Uint64 GetBusyCounter() const;
+};
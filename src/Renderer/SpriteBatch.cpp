@@ -0,0 +1,102 @@
+#include "SpriteBatch.h"
+#include <algorithm>
+#include <cmath>
+
+SpriteBatch::SpriteBatch() {
+	renderer = nullptr;
+	runTexture = nullptr;
+	runTextureWidth = 1;
+	runTextureHeight = 1;
+}
+
+void SpriteBatch::Begin(SDL_Renderer* renderer) {
+	this->renderer = renderer;
+	runTexture = nullptr;
+	vertices.clear();
+	indices.clear();
+}
+
+void SpriteBatch::Add(const SpriteDraw& sprite) {
+	if (!sprite.texture) {
+		return;
+	}
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (sprite.texture != runTexture) {
+		SubmitRun();
+		runTexture = sprite.texture;
+		SDL_QueryTexture(runTexture, NULL, NULL, &runTextureWidth, &runTextureHeight);
+	}
+	AppendQuad(sprite);
+#else
+	// SDL older than 2.0.18 has no geometry API, copy sprites one by one
+	SDL_RenderCopyEx(renderer, sprite.texture, &sprite.srcRect, &sprite.dstRect, sprite.rotation, NULL, sprite.flip);
+#endif
+}
+
+void SpriteBatch::Flush() {
+	SubmitRun();
+	runTexture = nullptr;
+}
+
+void SpriteBatch::AppendQuad(const SpriteDraw& sprite) {
+	// Texture coordinates, flipping is just swapping the edges
+	float u0 = static_cast<float>(sprite.srcRect.x) / runTextureWidth;
+	float v0 = static_cast<float>(sprite.srcRect.y) / runTextureHeight;
+	float u1 = static_cast<float>(sprite.srcRect.x + sprite.srcRect.w) / runTextureWidth;
+	float v1 = static_cast<float>(sprite.srcRect.y + sprite.srcRect.h) / runTextureHeight;
+	if (sprite.flip & SDL_FLIP_HORIZONTAL) {
+		std::swap(u0, u1);
+	}
+	if (sprite.flip & SDL_FLIP_VERTICAL) {
+		std::swap(v0, v1);
+	}
+
+	// Corners relative to the dst rect center, rotated clockwise like SDL_RenderCopyEx
+	const float halfW = sprite.dstRect.w / 2.0f;
+	const float halfH = sprite.dstRect.h / 2.0f;
+	const float centerX = sprite.dstRect.x + halfW;
+	const float centerY = sprite.dstRect.y + halfH;
+	float cosAngle = 1.0f;
+	float sinAngle = 0.0f;
+	if (sprite.rotation != 0.0) {
+		const double radians = sprite.rotation * M_PI / 180.0;
+		cosAngle = static_cast<float>(std::cos(radians));
+		sinAngle = static_cast<float>(std::sin(radians));
+	}
+
+	const float cornerX[4] = { -halfW, halfW, halfW, -halfW };
+	const float cornerY[4] = { -halfH, -halfH, halfH, halfH };
+	const float cornerU[4] = { u0, u1, u1, u0 };
+	const float cornerV[4] = { v0, v0, v1, v1 };
+
+	const int firstVertex = static_cast<int>(vertices.size());
+	for (int i = 0; i < 4; i++) {
+		SDL_Vertex vertex;
+		vertex.position.x = centerX + cornerX[i] * cosAngle - cornerY[i] * sinAngle;
+		vertex.position.y = centerY + cornerX[i] * sinAngle + cornerY[i] * cosAngle;
+		vertex.color = { 255, 255, 255, 255 };
+		vertex.tex_coord.x = cornerU[i];
+		vertex.tex_coord.y = cornerV[i];
+		vertices.push_back(vertex);
+	}
+
+	// two triangles per quad
+	const int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int index: quadIndices) {
+		indices.push_back(firstVertex + index);
+	}
+}
+
+void SpriteBatch::SubmitRun() {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (runTexture && !indices.empty()) {
+		SDL_RenderGeometry(
+			renderer, runTexture,
+			vertices.data(), static_cast<int>(vertices.size()),
+			indices.data(), static_cast<int>(indices.size())
+		);
+	}
+#endif
+	vertices.clear();
+	indices.clear();
+}
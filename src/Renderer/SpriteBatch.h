@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+// One textured quad as it would be passed to SDL_RenderCopyEx
+struct SpriteDraw {
+	SDL_Texture* texture;
+	int zIndex;
+	SDL_Rect srcRect;
+	SDL_Rect dstRect;
+	double rotation;
+	SDL_RendererFlip flip;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// SpriteBatch
+////////////////////////////////////////////////////////////////////////////////
+// Sprites must be added in draw order, ie sorted by (zIndex, texture).
+// Consecutive sprites sharing a texture are collected into one vertex/index
+// run that is submitted with a single SDL_RenderGeometry call.
+// Vertex and index buffers are kept between frames so steady state drawing
+// does not allocate.
+////////////////////////////////////////////////////////////////////////////////
+class SpriteBatch {
+	private:
+		SDL_Renderer* renderer;
+		SDL_Texture* runTexture;
+		int runTextureWidth;
+		int runTextureHeight;
+		std::vector<SDL_Vertex> vertices;
+		std::vector<int> indices;
+
+		void AppendQuad(const SpriteDraw& sprite);
+		void SubmitRun();
+
+	public:
+		SpriteBatch();
+
+		void Begin(SDL_Renderer* renderer);
+		void Add(const SpriteDraw& sprite);
+		void Flush();
+};
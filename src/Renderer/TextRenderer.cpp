@@ -0,0 +1,113 @@
+#include "TextRenderer.h"
+#include <algorithm>
+
+TextRenderer::TextLayout TextRenderer::BuildLayout(const GlyphAtlas& atlas, const std::string& text, const SDL_Color& color) {
+	TextLayout layout;
+	// labels were always drawn opaque, whatever alpha the color carries
+	layout.color = { color.r, color.g, color.b, 255 };
+	layout.height = atlas.GetLineHeight();
+	int penX = 0;
+	for (char character: text) {
+		const Glyph* glyph = atlas.GetGlyph(character);
+		if (!glyph) {
+			continue;
+		}
+		if (glyph->srcRect.w > 0) {
+			GlyphQuad quad;
+			quad.srcRect = glyph->srcRect;
+			quad.dstRect = { penX, 0, glyph->srcRect.w, glyph->srcRect.h };
+			layout.quads.push_back(quad);
+		}
+		penX += glyph->advance;
+	}
+	layout.width = penX;
+
+	return layout;
+}
+
+const TextRenderer::TextLayout& TextRenderer::GetLayout(const GlyphAtlas& atlas, const std::string& text, const SDL_Color& color) {
+	// key = atlas id + rgb + text, built in a reused string
+	scratchKey.clear();
+	const uint32_t atlasId = atlas.GetId();
+	scratchKey.append(reinterpret_cast<const char*>(&atlasId), sizeof(atlasId));
+	scratchKey.push_back(static_cast<char>(color.r));
+	scratchKey.push_back(static_cast<char>(color.g));
+	scratchKey.push_back(static_cast<char>(color.b));
+	scratchKey.append(text);
+
+	auto cached = layouts.find(scratchKey);
+	if (cached != layouts.end()) {
+		return cached->second;
+	}
+
+	if (layouts.size() >= MAX_CACHED_LAYOUTS) {
+		layouts.clear();
+	}
+	return layouts.emplace(scratchKey, BuildLayout(atlas, text, color)).first->second;
+}
+
+SDL_Point TextRenderer::DrawText(SDL_Renderer* renderer, const GlyphAtlas& atlas, const std::string& text, const SDL_Color& color, int x, int y) {
+	return Submit(renderer, atlas, GetLayout(atlas, text, color), x, y);
+}
+
+SDL_Point TextRenderer::DrawLabel(SDL_Renderer* renderer, const GlyphAtlas& atlas, const std::string& label, const SDL_Color& color, int x, int y) {
+	const LabelKey key = { &label, atlas.GetId(), (static_cast<uint32_t>(color.r) << 16) | (static_cast<uint32_t>(color.g) << 8) | color.b };
+	auto cached = labelLayouts.find(key);
+	if (cached == labelLayouts.end()) {
+		if (labelLayouts.size() >= MAX_CACHED_LAYOUTS) {
+			labelLayouts.clear();
+		}
+		cached = labelLayouts.emplace(key, BuildLayout(atlas, label, color)).first;
+	}
+	return Submit(renderer, atlas, cached->second, x, y);
+}
+
+SDL_Point TextRenderer::Submit(SDL_Renderer* renderer, const GlyphAtlas& atlas, const TextLayout& layout, int x, int y) {
+	SDL_Texture* texture = atlas.GetTexture();
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	int textureWidth = 1;
+	int textureHeight = 1;
+	SDL_QueryTexture(texture, NULL, NULL, &textureWidth, &textureHeight);
+
+	vertices.clear();
+	for (const auto& quad: layout.quads) {
+		const float left = static_cast<float>(x + quad.dstRect.x);
+		const float top = static_cast<float>(y + quad.dstRect.y);
+		const float right = left + quad.dstRect.w;
+		const float bottom = top + quad.dstRect.h;
+		const float u0 = static_cast<float>(quad.srcRect.x) / textureWidth;
+		const float v0 = static_cast<float>(quad.srcRect.y) / textureHeight;
+		const float u1 = static_cast<float>(quad.srcRect.x + quad.srcRect.w) / textureWidth;
+		const float v1 = static_cast<float>(quad.srcRect.y + quad.srcRect.h) / textureHeight;
+		vertices.push_back({ { left, top }, layout.color, { u0, v0 } });
+		vertices.push_back({ { right, top }, layout.color, { u1, v0 } });
+		vertices.push_back({ { right, bottom }, layout.color, { u1, v1 } });
+		vertices.push_back({ { left, bottom }, layout.color, { u0, v1 } });
+	}
+
+	// Index pattern is the same for every label, only grow it
+	const size_t numIndices = layout.quads.size() * 6;
+	for (size_t quad = indices.size() / 6; indices.size() < numIndices; quad++) {
+		const int firstVertex = static_cast<int>(quad * 4);
+		const int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+		for (int index: quadIndices) {
+			indices.push_back(firstVertex + index);
+		}
+	}
+
+	if (!vertices.empty()) {
+		SDL_RenderGeometry(renderer, texture, vertices.data(), static_cast<int>(vertices.size()), indices.data(), static_cast<int>(numIndices));
+	}
+#else
+	// SDL older than 2.0.18 has no geometry API, tint the atlas and copy glyph by glyph
+	SDL_SetTextureColorMod(texture, layout.color.r, layout.color.g, layout.color.b);
+	for (const auto& quad: layout.quads) {
+		SDL_Rect dstRect = { x + quad.dstRect.x, y + quad.dstRect.y, quad.dstRect.w, quad.dstRect.h };
+		SDL_RenderCopy(renderer, texture, &quad.srcRect, &dstRect);
+	}
+#endif
+
+	SDL_Point size = { layout.width, layout.height };
+	return size;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../AssetStore/GlyphAtlas.h"
+#include <SDL2/SDL.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// TextRenderer
+////////////////////////////////////////////////////////////////////////////////
+// Draws strings from a GlyphAtlas. The glyph quads of a string are laid out
+// once and cached by (atlas, color, text); later frames only offset the cached
+// quads and submit them with one SDL_RenderGeometry call per label. Labels
+// that never change are cached by address instead, so a frame full of them
+// doesn't build a key string for each.
+////////////////////////////////////////////////////////////////////////////////
+class TextRenderer {
+	private:
+		struct GlyphQuad {
+			SDL_Rect srcRect;
+			SDL_Rect dstRect;	// relative to the label position
+		};
+
+		struct TextLayout {
+			std::vector<GlyphQuad> quads;
+			SDL_Color color;
+			int width;
+			int height;
+		};
+
+		struct LabelKey {
+			const std::string* label;
+			uint32_t atlasId;
+			uint32_t rgb;
+
+			bool operator==(const LabelKey& other) const {
+				return label == other.label && atlasId == other.atlasId && rgb == other.rgb;
+			}
+		};
+
+		struct LabelKeyHash {
+			size_t operator()(const LabelKey& key) const {
+				return std::hash<const void*>()(key.label) ^ (static_cast<size_t>(key.atlasId) << 24) ^ key.rgb;
+			}
+		};
+
+		// Cached layouts are dropped wholesale once the cache grows past this
+		static const size_t MAX_CACHED_LAYOUTS = 1024;
+
+		std::unordered_map<std::string, TextLayout> layouts;
+		std::unordered_map<LabelKey, TextLayout, LabelKeyHash> labelLayouts;
+		std::string scratchKey;
+		std::vector<SDL_Vertex> vertices;
+		std::vector<int> indices;
+
+		static TextLayout BuildLayout(const GlyphAtlas& atlas, const std::string& text, const SDL_Color& color);
+		const TextLayout& GetLayout(const GlyphAtlas& atlas, const std::string& text, const SDL_Color& color);
+		SDL_Point Submit(SDL_Renderer* renderer, const GlyphAtlas& atlas, const TextLayout& layout, int x, int y);
+
+	public:
+		TextRenderer() = default;
+
+		// Draws text with its top left corner at (x, y), returns the label size
+		SDL_Point DrawText(SDL_Renderer* renderer, const GlyphAtlas& atlas, const std::string& text, const SDL_Color& color, int x, int y);
+
+		// Same for a label that lives as long as the renderer and never changes
+		SDL_Point DrawLabel(SDL_Renderer* renderer, const GlyphAtlas& atlas, const std::string& label, const SDL_Color& color, int x, int y);
+};
@@ -0,0 +1,74 @@
+#include "ScriptProfiler.h"
+#include <algorithm>
+
+namespace {
+	// weight of the newest tick in averageMs
+	const double AVERAGE_WEIGHT = 0.1;
+}
+
+std::string ScriptProfiler::GetFunctionName(const sol::function& func) {
+	lua_State* L = func.lua_state();
+	if (!L) {
+		return "?";
+	}
+	lua_Debug info;
+	func.push();
+	if (!lua_getinfo(L, ">S", &info)) { // pops the function
+		return "?";
+	}
+	std::string name = info.short_src;
+	if (info.linedefined > 0) {
+		name += ":" + std::to_string(info.linedefined);
+	}
+	return name;
+}
+
+ScriptProfile& ScriptProfiler::Find(const sol::function& func) {
+	auto it = profiles.find(func.pointer());
+	if (it == profiles.end()) {
+		ScriptProfile profile;
+		profile.name = GetFunctionName(func);
+		it = profiles.emplace(func.pointer(), profile).first;
+	}
+	return it->second;
+}
+
+void ScriptProfiler::AddRun(const sol::function& func, size_t numEntities, double seconds) {
+	ScriptProfile& profile = Find(func);
+	const double ms = seconds * 1000.0;
+	profile.numEntities = numEntities;
+	profile.lastMs = ms;
+	profile.averageMs = profile.totalMs > 0.0 ? profile.averageMs + (ms - profile.averageMs) * AVERAGE_WEIGHT : ms;
+	profile.maxMs = std::max(profile.maxMs, ms);
+	profile.totalMs += ms;
+	profile.numDeferred = 0;
+	profile.deferredMs = 0.0;
+}
+
+void ScriptProfiler::AddDeferred(const sol::function& func, double deferredSeconds) {
+	ScriptProfile& profile = Find(func);
+	profile.numDeferred++;
+	profile.deferredMs = deferredSeconds * 1000.0;
+	profile.totalDeferred++;
+}
+
+void ScriptProfiler::Forget(const sol::function& func) {
+	profiles.erase(func.pointer());
+}
+
+void ScriptProfiler::SetTickStats(const ScriptTickStats& stats) {
+	tickStats = stats;
+}
+
+std::vector<ScriptProfile> ScriptProfiler::GetProfiles() const {
+	std::vector<ScriptProfile> result;
+	result.reserve(profiles.size());
+	for (const auto& it: profiles) {
+		result.push_back(it.second);
+	}
+	return result;
+}
+
+ScriptTickStats ScriptProfiler::GetTickStats() const {
+	return tickStats;
+}
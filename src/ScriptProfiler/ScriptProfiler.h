@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sol/sol.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Timings of one script function, over all the entities that run it
+struct ScriptProfile {
+	std::string name;		// where the function is defined, eg Level1.lua:2794
+	size_t numEntities = 0;
+	double lastMs = 0.0;
+	double averageMs = 0.0;	// smoothed over recent ticks
+	double maxMs = 0.0;
+	double totalMs = 0.0;
+	int numDeferred = 0;	// ticks it's been waiting on the budget since it last ran
+	double deferredMs = 0.0;	// time it missed meanwhile, added to its next delta_time
+	int totalDeferred = 0;
+};
+
+struct ScriptTickStats {
+	double lastMs = 0.0;
+	double budgetMs = 0.0;	// 0 when unbounded
+	int numRun = 0;
+	int numDeferred = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// ScriptProfiler
+////////////////////////////////////////////////////////////////////////////////
+// What each script function cost, for the debug GUI. ScriptSystem runs a
+// function for all its entities at once, so that's what is timed; profiles go
+// with the last entity running the function.
+////////////////////////////////////////////////////////////////////////////////
+class ScriptProfiler {
+	private:
+		std::unordered_map<const void*, ScriptProfile> profiles; // by function
+		ScriptTickStats tickStats;
+
+		ScriptProfile& Find(const sol::function& func);
+
+	public:
+		static std::string GetFunctionName(const sol::function& func);
+
+		void AddRun(const sol::function& func, size_t numEntities, double seconds);
+		void AddDeferred(const sol::function& func, double deferredSeconds);
+		void Forget(const sol::function& func);
+		void SetTickStats(const ScriptTickStats& stats);
+
+		std::vector<ScriptProfile> GetProfiles() const;
+		ScriptTickStats GetTickStats() const;
+};
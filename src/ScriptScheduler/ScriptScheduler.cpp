@@ -0,0 +1,241 @@
+#include "ScriptScheduler.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Plain Lua so they yield from the script's own coroutine, the scheduler
+	// reads what was yielded. coroutine is looked up on each call, the library
+	// may be opened after the bindings
+	const char* const SCRIPT_WAIT_FUNCTIONS = R"(
+		function wait(seconds) return coroutine.yield(1, seconds or 0) end
+		function wait_until(condition) return coroutine.yield(2, condition) end
+		function wait_event(name) return coroutine.yield(3, name) end
+	)";
+}
+
+ScriptScheduler::ScriptScheduler(): wheel(WHEEL_SLOTS) {
+	nextSerial = 0;
+	tick = 0;
+	tickSeconds = 1.0 / 60.0;
+}
+
+void ScriptScheduler::CreateLuaBindings(sol::state& lua) {
+	lua.script(SCRIPT_WAIT_FUNCTIONS);
+	lua.set_function("emit_event", [this](const std::string& name) { EmitEvent(name); });
+}
+
+void ScriptScheduler::Start(Entity entity, const sol::function& func) {
+	Stop(entity);
+	if (!func.valid()) {
+		return;
+	}
+	// each script gets its own thread to yield from
+	sol::thread thread = sol::thread::create(func.lua_state());
+	sol::coroutine coroutine(thread.thread_state(), func);
+	const TaskRef ref = { entity.GetId(), nextSerial++ };
+	tasks.emplace(ref.entityId, Task { entity, ref.serial, thread, coroutine, sol::lua_nil, "", SCRIPT_WAIT_TICK, false });
+	ready.push_back(ref);
+}
+
+void ScriptScheduler::Stop(Entity entity) {
+	auto it = tasks.find(entity.GetId());
+	if (it == tasks.end()) {
+		return;
+	}
+	// stale wheel, ready and condition entries are dropped when they're next
+	// looked at, only event waiters could sit around forever
+	if (it->second.wait == SCRIPT_WAIT_EVENT) {
+		auto waiters = eventWaiters.find(it->second.event);
+		if (waiters != eventWaiters.end()) {
+			const size_t entityId = entity.GetId();
+			waiters->second.erase(std::remove_if(waiters->second.begin(), waiters->second.end(), [entityId](const TaskRef& ref) { return ref.entityId == entityId; }), waiters->second.end());
+			if (waiters->second.empty()) {
+				eventWaiters.erase(waiters);
+			}
+		}
+	}
+	tasks.erase(it);
+}
+
+ScriptScheduler::Task* ScriptScheduler::Find(const TaskRef& ref) {
+	auto it = tasks.find(ref.entityId);
+	return it != tasks.end() && it->second.serial == ref.serial ? &it->second : nullptr;
+}
+
+void ScriptScheduler::End(const TaskRef& ref) {
+	if (Task* task = Find(ref)) {
+		Stop(task->entity);
+	}
+}
+
+void ScriptScheduler::Resume(const TaskRef& ref) {
+	Task* task = Find(ref);
+	if (!task) {
+		return;
+	}
+	task->wait = SCRIPT_WAIT_TICK;
+	task->condition = sol::lua_nil;
+	task->event.clear();
+
+	stats.numResumed++;
+	sol::protected_function_result result;
+	if (task->isStarted) {
+		result = task->coroutine();
+	} else {
+		task->isStarted = true;
+		result = task->coroutine(task->entity);
+	}
+
+	// the script may have stopped its own entity's task
+	task = Find(ref);
+	if (!task) {
+		return;
+	}
+	if (!result.valid()) {
+		sol::error err = result;
+		Logger::Err("Coroutine script of entity " + std::to_string(ref.entityId) + " stopped: " + err.what());
+		End(ref);
+		return;
+	}
+	if (result.status() != sol::call_status::yielded) {
+		// returned, the script is done
+		End(ref);
+		return;
+	}
+
+	const int wait = result.return_count() > 0 ? result.get<sol::optional<int>>(0).value_or(SCRIPT_WAIT_TICK) : SCRIPT_WAIT_TICK;
+	switch (wait) {
+		case SCRIPT_WAIT_TIME:
+			task->wait = SCRIPT_WAIT_TIME;
+			Schedule(ref, result.get<sol::optional<double>>(1).value_or(0.0));
+			break;
+		case SCRIPT_WAIT_CONDITION: {
+			sol::optional<sol::function> condition = result.get<sol::optional<sol::function>>(1);
+			if (!condition) {
+				Logger::Err("Coroutine script of entity " + std::to_string(ref.entityId) + " stopped: wait_until needs a function");
+				End(ref);
+				return;
+			}
+			task->wait = SCRIPT_WAIT_CONDITION;
+			task->condition = *condition;
+			conditionWaiters.push_back(ref);
+			break;
+		}
+		case SCRIPT_WAIT_EVENT: {
+			sol::optional<std::string> event = result.get<sol::optional<std::string>>(1);
+			if (!event) {
+				Logger::Err("Coroutine script of entity " + std::to_string(ref.entityId) + " stopped: wait_event needs a name");
+				End(ref);
+				return;
+			}
+			task->wait = SCRIPT_WAIT_EVENT;
+			task->event = *event;
+			eventWaiters[*event].push_back(ref);
+			break;
+		}
+		default:
+			ready.push_back(ref);
+			break;
+	}
+}
+
+void ScriptScheduler::Schedule(const TaskRef& ref, double seconds) {
+	// at least the next tick, wait(0) is a plain yield. This tick's slot was
+	// settled before anything resumed, so the next time it's looked at is a
+	// full turn away and rounds counts the turns after that one. A whole
+	// number of ticks in seconds often divides back a hair over, that's not
+	// worth another tick
+	const double numTicks = std::max(0.0, seconds) / tickSeconds;
+	const uint64_t ticks = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(numTicks - 1e-6)));
+	const uint64_t slot = (tick + ticks) % WHEEL_SLOTS;
+	wheel[slot].push_back({ ref, static_cast<uint32_t>((ticks - 1) / WHEEL_SLOTS) });
+}
+
+void ScriptScheduler::EmitEvent(const std::string& name) {
+	auto waiters = eventWaiters.find(name);
+	if (waiters == eventWaiters.end()) {
+		return;
+	}
+	// ready is only picked up at the start of a tick, so even a script that
+	// emits wakes the waiters next tick, never while it's running
+	ready.insert(ready.end(), waiters->second.begin(), waiters->second.end());
+	eventWaiters.erase(waiters);
+}
+
+void ScriptScheduler::Update(double dt) {
+	if (dt > 0.0) {
+		tickSeconds = dt;
+	}
+	tick++;
+	stats.numResumed = 0;
+
+	// Settle this tick's slot before any script runs: a wait of WHEEL_SLOTS
+	// ticks made below lands in it, and must not be taken as due right away.
+	// The entries due on a later round stay for it
+	std::vector<TimerEntry>& slot = wheel[tick % WHEEL_SLOTS];
+	size_t numKept = 0;
+	for (TimerEntry& entry: slot) {
+		if (entry.rounds > 0) {
+			entry.rounds--;
+			slot[numKept++] = entry;
+		} else {
+			dueTimers.push_back(entry);
+		}
+	}
+	slot.resize(numKept);
+
+	// Conditions first, a script only starts waiting on one after this tick's
+	// check so it's never resumed twice in a tick
+	resuming.swap(conditionWaiters);
+	for (const TaskRef& ref: resuming) {
+		Task* task = Find(ref);
+		if (!task || task->wait != SCRIPT_WAIT_CONDITION) {
+			continue;
+		}
+		sol::protected_function_result result = task->condition();
+		if (!result.valid()) {
+			sol::error err = result;
+			Logger::Err("wait_until condition of entity " + std::to_string(ref.entityId) + " failed: " + err.what());
+			End(ref);
+			continue;
+		}
+		const bool isMet = result.get<sol::optional<bool>>(0).value_or(false);
+		if (isMet) {
+			Resume(ref);
+		} else {
+			stillWaiting.push_back(ref);
+		}
+	}
+	resuming.clear();
+	conditionWaiters.insert(conditionWaiters.end(), stillWaiting.begin(), stillWaiting.end());
+	stillWaiting.clear();
+
+	// New scripts, plain yields and woken event waiters
+	resuming.swap(ready);
+	for (const TaskRef& ref: resuming) {
+		Resume(ref);
+	}
+	resuming.clear();
+
+	// Then what was due on the wheel
+	for (const TimerEntry& entry: dueTimers) {
+		const Task* task = Find(entry.task);
+		if (task && task->wait == SCRIPT_WAIT_TIME) {
+			Resume(entry.task);
+		}
+	}
+	dueTimers.clear();
+}
+
+ScriptSchedulerStats ScriptScheduler::GetStats() const {
+	ScriptSchedulerStats result;
+	result.numTasks = tasks.size();
+	for (const auto& it: tasks) {
+		result.numWaitingTime += it.second.wait == SCRIPT_WAIT_TIME;
+		result.numWaitingCondition += it.second.wait == SCRIPT_WAIT_CONDITION;
+		result.numWaitingEvent += it.second.wait == SCRIPT_WAIT_EVENT;
+	}
+	result.numResumed = stats.numResumed;
+	return result;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../ECS/ECS.h"
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// What a script yields to the scheduler, first value of coroutine.yield
+enum ScriptWait {
+	SCRIPT_WAIT_TICK = 0,	// plain yield, resumed next tick
+	SCRIPT_WAIT_TIME = 1,
+	SCRIPT_WAIT_CONDITION = 2,
+	SCRIPT_WAIT_EVENT = 3
+};
+
+struct ScriptSchedulerStats {
+	size_t numTasks = 0;
+	size_t numWaitingTime = 0;
+	size_t numWaitingCondition = 0;
+	size_t numWaitingEvent = 0;
+	int numResumed = 0;	// last tick
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// ScriptScheduler
+////////////////////////////////////////////////////////////////////////////////
+// Runs entity scripts as Lua coroutines that say when they want to run again:
+//   wait(seconds)          resumed after that long
+//   wait_until(condition)  resumed once condition() returns true
+//   wait_event(name)       resumed after emit_event(name)
+//
+// Timed waits sit in a timer wheel of WHEEL_SLOTS ticks, a wait longer than
+// the wheel goes round it. A tick only looks at its own slot, so scripts
+// waiting on time cost nothing until they're due. Conditions are polled
+// every tick, events wake their waiters on the next one.
+////////////////////////////////////////////////////////////////////////////////
+class ScriptScheduler {
+	private:
+		struct Task {
+			Entity entity;
+			uint32_t serial;	// tells a restarted task from the one stale wheel entries were for
+			sol::thread thread;
+			sol::coroutine coroutine;
+			sol::function condition;	// wait_until's
+			std::string event;		// wait_event's
+			ScriptWait wait;
+			bool isStarted;
+		};
+
+		// Refers to a task by entity, stale once the task stopped or restarted
+		struct TaskRef {
+			size_t entityId;
+			uint32_t serial;
+		};
+
+		struct TimerEntry {
+			TaskRef task;
+			uint32_t rounds;	// times round the wheel before it's due
+		};
+
+		static const size_t WHEEL_SLOTS = 256;
+
+		std::unordered_map<size_t, Task> tasks; // by entity id
+		uint32_t nextSerial;
+		std::vector<std::vector<TimerEntry>> wheel;
+		uint64_t tick;
+		double tickSeconds;
+		std::vector<TaskRef> ready;
+		std::vector<TaskRef> conditionWaiters;
+		std::unordered_map<std::string, std::vector<TaskRef>> eventWaiters;
+
+		// Reused frame to frame so ticks don't allocate
+		std::vector<TimerEntry> dueTimers;
+		std::vector<TaskRef> resuming;
+		std::vector<TaskRef> stillWaiting;
+		ScriptSchedulerStats stats;
+
+		Task* Find(const TaskRef& ref);
+		void Resume(const TaskRef& ref);
+		void End(const TaskRef& ref);
+		void Schedule(const TaskRef& ref, double seconds);
+
+	public:
+		ScriptScheduler();
+		ScriptScheduler(const ScriptScheduler&) = delete;
+		ScriptScheduler& operator=(const ScriptScheduler&) = delete;
+
+		// wait, wait_until, wait_event and emit_event
+		void CreateLuaBindings(sol::state& lua);
+
+		// The script starts on the next tick with the entity as its argument
+		void Start(Entity entity, const sol::function& func);
+		void Stop(Entity entity);
+
+		// One fixed tick: resumes the conditions that came true, the new, yielded
+		// and woken scripts, then what's due on the wheel
+		void Update(double dt);
+		// Waiters resume on the next tick
+		void EmitEvent(const std::string& name);
+
+		ScriptSchedulerStats GetStats() const;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+
+////////////////////////////////////////////////////////////////////////////////
+// SimulationClock
+////////////////////////////////////////////////////////////////////////////////
+// Time as seen by gameplay code. It only moves forward by whole fixed ticks,
+// so timers (animations, projectile lifetimes, emitters, scripts) behave the
+// same regardless of tick rate, frame rate or hitches. Use this instead of
+// SDL_GetTicks anywhere the simulation depends on time.
+// Only the main thread advances it, but components read it when they're
+// constructed, which the level preloader does on its own thread.
+////////////////////////////////////////////////////////////////////////////////
+class SimulationClock {
+	private:
+		static inline std::atomic<double> millisecs { 0.0 };
+
+	public:
+		static Uint32 GetTicks() {
+			return static_cast<Uint32>(millisecs.load(std::memory_order_relaxed));
+		}
+
+		static void Advance(double seconds) {
+			// one writer, no need for a read-modify-write
+			millisecs.store(millisecs.load(std::memory_order_relaxed) + seconds * 1000.0, std::memory_order_relaxed);
+		}
+};
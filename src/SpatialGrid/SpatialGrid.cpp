@@ -0,0 +1,114 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+
+SpatialGrid::SpatialGrid(int cellSize): cellSize(cellSize) {
+	queryStamp = 0;
+}
+
+uint64_t SpatialGrid::GetCellKey(int cellX, int cellY) {
+	return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+}
+
+// Floor division so negative coordinates land in negative cells
+int SpatialGrid::ToCell(int coordinate) const {
+	return coordinate >= 0 ? coordinate / cellSize : -((-coordinate - 1) / cellSize) - 1;
+}
+
+SpatialGrid::CellRange SpatialGrid::GetCellRange(const SDL_Rect& bounds) const {
+	CellRange range;
+	range.minX = ToCell(bounds.x);
+	range.minY = ToCell(bounds.y);
+	range.maxX = ToCell(bounds.x + std::max(bounds.w, 0));
+	range.maxY = ToCell(bounds.y + std::max(bounds.h, 0));
+	range.isInserted = true;
+	return range;
+}
+
+void SpatialGrid::AddToCells(size_t id, const CellRange& range) {
+	for (int cellY = range.minY; cellY <= range.maxY; cellY++) {
+		for (int cellX = range.minX; cellX <= range.maxX; cellX++) {
+			cells[GetCellKey(cellX, cellY)].push_back(id);
+		}
+	}
+}
+
+void SpatialGrid::RemoveFromCells(size_t id, const CellRange& range) {
+	for (int cellY = range.minY; cellY <= range.maxY; cellY++) {
+		for (int cellX = range.minX; cellX <= range.maxX; cellX++) {
+			auto cell = cells.find(GetCellKey(cellX, cellY));
+			if (cell == cells.end()) {
+				continue;
+			}
+			auto& items = cell->second;
+			auto item = std::find(items.begin(), items.end(), id);
+			if (item != items.end()) {
+				// order inside a cell doesn't matter, swap with last
+				*item = items.back();
+				items.pop_back();
+			}
+		}
+	}
+}
+
+void SpatialGrid::Insert(size_t id, const SDL_Rect& bounds) {
+	if (id >= cellRangePerItem.size()) {
+		cellRangePerItem.resize(id + 1, CellRange{ 0, 0, 0, 0, false });
+		queryStampPerItem.resize(id + 1, 0);
+	}
+	if (cellRangePerItem[id].isInserted) {
+		Update(id, bounds);
+		return;
+	}
+	CellRange range = GetCellRange(bounds);
+	AddToCells(id, range);
+	cellRangePerItem[id] = range;
+}
+
+void SpatialGrid::Update(size_t id, const SDL_Rect& bounds) {
+	if (id >= cellRangePerItem.size() || !cellRangePerItem[id].isInserted) {
+		Insert(id, bounds);
+		return;
+	}
+	CellRange& current = cellRangePerItem[id];
+	CellRange range = GetCellRange(bounds);
+	if (range.minX == current.minX && range.minY == current.minY && range.maxX == current.maxX && range.maxY == current.maxY) {
+		return; // still in the same cells
+	}
+	RemoveFromCells(id, current);
+	AddToCells(id, range);
+	current = range;
+}
+
+void SpatialGrid::Remove(size_t id) {
+	if (id >= cellRangePerItem.size() || !cellRangePerItem[id].isInserted) {
+		return;
+	}
+	RemoveFromCells(id, cellRangePerItem[id]);
+	cellRangePerItem[id].isInserted = false;
+}
+
+void SpatialGrid::Clear() {
+	cells.clear();
+	cellRangePerItem.clear();
+	queryStampPerItem.clear();
+}
+
+void SpatialGrid::Query(const SDL_Rect& area, std::vector<size_t>& result) {
+	// stamp items as they are found so items spanning several cells come out once
+	queryStamp++;
+	CellRange range = GetCellRange(area);
+	for (int cellY = range.minY; cellY <= range.maxY; cellY++) {
+		for (int cellX = range.minX; cellX <= range.maxX; cellX++) {
+			auto cell = cells.find(GetCellKey(cellX, cellY));
+			if (cell == cells.end()) {
+				continue;
+			}
+			for (auto id: cell->second) {
+				if (queryStampPerItem[id] != queryStamp) {
+					queryStampPerItem[id] = queryStamp;
+					result.push_back(id);
+				}
+			}
+		}
+	}
+}
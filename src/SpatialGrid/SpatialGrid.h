@@ -0,0 +1,50 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// SpatialGrid
+////////////////////////////////////////////////////////////////////////////////
+// Sparse uniform grid over world space. Items are identified by a small
+// integer id (eg entity id) and registered in every cell their bounds touch.
+// Cells are hashed, so the grid needs no world bounds and items outside the
+// map still work. Update only touches cells when an item crosses a cell edge.
+////////////////////////////////////////////////////////////////////////////////
+class SpatialGrid {
+	private:
+		struct CellRange {
+			int minX;
+			int minY;
+			int maxX;
+			int maxY;
+			bool isInserted;
+		};
+
+		int cellSize;
+		std::unordered_map<uint64_t, std::vector<size_t>> cells;
+
+		// Per item bookkeeping [index = item id]
+		std::vector<CellRange> cellRangePerItem;
+		std::vector<uint32_t> queryStampPerItem;
+		uint32_t queryStamp;
+
+		static uint64_t GetCellKey(int cellX, int cellY);
+		int ToCell(int coordinate) const;
+		CellRange GetCellRange(const SDL_Rect& bounds) const;
+		void AddToCells(size_t id, const CellRange& range);
+		void RemoveFromCells(size_t id, const CellRange& range);
+
+	public:
+		SpatialGrid(int cellSize = 256);
+
+		void Insert(size_t id, const SDL_Rect& bounds);
+		void Update(size_t id, const SDL_Rect& bounds);
+		void Remove(size_t id);
+		void Clear();
+
+		// Appends every item whose cells overlap the area, each item at most once
+		void Query(const SDL_Rect& area, std::vector<size_t>& result);
+};
@@ -3,6 +3,7 @@
 #include "../ECS/ECS.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/AnimationComponent.h"
+#include "../SimulationClock/SimulationClock.h"
 
 class AnimationSystem: public System {
 	public:
@@ -20,7 +21,7 @@ class AnimationSystem: public System {
 				// framespeed = frames/second
 
 				// alternate between 0 and 1 every 1/5 sec
-				animation.currentFrame = ((SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000) % animation.numFrames;
+				animation.currentFrame = ((SimulationClock::GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000) % animation.numFrames;
 				sprite.srcRect.x = animation.currentFrame * sprite.width;
 			}
 		}
@@ -4,64 +4,112 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/TransformComponent.h"
 #include "../EventBus/EventBus.h"
+#include "../ThreadPool/ThreadPool.h"
 #include"../Events/CollisionEvent.h"
+#include "../Renderer/RenderCommandList.h"
+#include <vector>
+#include <algorithm>
 
 class CollisionSystem: public System {
+	private:
+		// Collider box in world space, tagged with the entity's index in the system entity list
+		struct ColliderBox {
+			int left;
+			int right;
+			int top;
+			int bottom;
+			size_t index;
+		};
+
+		// pair of system entity indices, always stored as (lower, higher)
+		typedef std::pair<size_t, size_t> CollisionPair;
+
+		// Reused frame to frame so the hot path doesn't allocate
+		std::vector<ColliderBox> boxes;
+		std::vector<std::vector<CollisionPair>> collisionsPerSlot;
+		std::vector<CollisionPair> collisions;
+
+		// Boxes per chunk of the sweep handed to a worker
+		static const size_t SWEEP_GRAIN_SIZE = 64;
+
 	public:
 		CollisionSystem() {
 			RequireComponent<TransformComponent>();
 			RequireComponent<BoxColliderComponent>();
 		}
 
-		void Update(std::unique_ptr<EventBus>& eventBus) {
+		void Update(std::unique_ptr<EventBus>& eventBus, ThreadPool& threadPool) {
 			auto entities = GetSystemEntities();
 
-			// iterator approach, each i is a pointer to an entity
-			// don't duplicate checks
-			for (auto i = entities.begin(); i != entities.end(); i++) {
-				Entity a = *i;
-				auto atx = a.GetComponent<TransformComponent>();
-				auto acx = a.GetComponent<BoxColliderComponent>();
-
-				int aLeft = atx.position.x + acx.offset.x;
-				int aRight = atx.position.x + acx.offset.x + (acx.width * atx.scale.x);
-				int aTop = atx.position.y + acx.offset.y;
-				int aBottom = atx.position.y + acx.offset.y + (acx.height * atx.scale.y);
-
-				for (auto j = i; j != entities.end(); j++) {
-					Entity b = *j;
-
-					if (a == b) continue;	// bypass if same entity
-
-					auto btx = b.GetComponent<TransformComponent>();
-					auto bcx = b.GetComponent<BoxColliderComponent>();
-
-					int bLeft = btx.position.x + bcx.offset.x;
-					int bRight = btx.position.x + bcx.offset.x + (bcx.width * btx.scale.x);
-					int bTop = btx.position.y + bcx.offset.y;
-					int bBottom = btx.position.y + bcx.offset.y + (bcx.height * btx.scale.y);
-
-					bool isColliding = (
-						aLeft < bRight &&
-						aRight > bLeft &&
-						aTop < bBottom &&
-						aBottom > bTop
-					);
-
-					if(isColliding) {
-						Logger::Log("COLLISION Entity " + std::to_string(a.GetId()) + " and Entity " + std::to_string(b.GetId()));
-						eventBus->EmitEvent<CollisionEvent>(a, b);
-					}
+			// Gather collider boxes up front, workers never touch the registry
+			boxes.clear();
+			for (size_t i = 0; i < entities.size(); i++) {
+				const auto& atx = entities[i].GetComponent<TransformComponent>();
+				const auto& acx = entities[i].GetComponent<BoxColliderComponent>();
+
+				ColliderBox box;
+				box.left = atx.position.x + acx.offset.x;
+				box.right = atx.position.x + acx.offset.x + (acx.width * atx.scale.x);
+				box.top = atx.position.y + acx.offset.y;
+				box.bottom = atx.position.y + acx.offset.y + (acx.height * atx.scale.y);
+				box.index = i;
+				boxes.push_back(box);
+			}
+
+			// Broad phase: sort and sweep along x, only boxes whose x intervals
+			// overlap become candidate pairs
+			std::sort(boxes.begin(), boxes.end(), [](const ColliderBox& a, const ColliderBox& b) {
+				return a.left < b.left || (a.left == b.left && a.index < b.index);
+			});
 
+			// Narrow phase: each box sweeps forward over the sorted list, chunks of
+			// boxes are spread over the thread pool, results go to per-slot buffers
+			collisionsPerSlot.resize(threadPool.GetNumSlots());
+			for (auto& slotCollisions: collisionsPerSlot) {
+				slotCollisions.clear();
+			}
+
+			threadPool.ParallelFor(boxes.size(), SWEEP_GRAIN_SIZE, [this](size_t begin, size_t end, size_t slot) {
+				auto& slotCollisions = collisionsPerSlot[slot];
+				for (size_t i = begin; i < end; i++) {
+					const ColliderBox& a = boxes[i];
+					for (size_t j = i + 1; j < boxes.size() && boxes[j].left < a.right; j++) {
+						const ColliderBox& b = boxes[j];
+
+						bool isColliding = (
+							a.left < b.right &&
+							a.right > b.left &&
+							a.top < b.bottom &&
+							a.bottom > b.top
+						);
+
+						if (isColliding) {
+							slotCollisions.emplace_back(std::min(a.index, b.index), std::max(a.index, b.index));
+						}
+					}
 				}
+			});
+
+			// Merge and sort so events go out in the same order as a plain
+			// pairwise loop over the system entities, whatever the thread count
+			collisions.clear();
+			for (const auto& slotCollisions: collisionsPerSlot) {
+				collisions.insert(collisions.end(), slotCollisions.begin(), slotCollisions.end());
+			}
+			std::sort(collisions.begin(), collisions.end());
+
+			for (const auto& collision: collisions) {
+				Entity a = entities[collision.first];
+				Entity b = entities[collision.second];
+				Logger::Log("COLLISION Entity " + std::to_string(a.GetId()) + " and Entity " + std::to_string(b.GetId()));
+				eventBus->EmitEvent<CollisionEvent>(a, b);
 			}
 		}
 
-		void Render(SDL_Renderer* renderer, SDL_Rect& camera) {
+		void Render(RenderCommandList& frame, SDL_Rect& camera) {
 			for (auto entity: GetSystemEntities()) {
 				auto eTx = entity.GetComponent<TransformComponent>();
 				auto eCx = entity.GetComponent<BoxColliderComponent>();
-				SDL_SetRenderDrawColor(renderer, 0, 255, 255, 255);
 				SDL_Rect colliderRect = { 
 					static_cast<int>(eTx.position.x + eCx.offset.x - camera.x), 
 					static_cast<int>(eTx.position.y + eCx.offset.y - camera.y), 
@@ -69,7 +117,7 @@ class CollisionSystem: public System {
 					static_cast<int>(eCx.height * eTx.scale.y) 
 				};
 
-				SDL_RenderDrawRect(renderer, &colliderRect);
+				frame.AddDrawRect(colliderRect, { 0, 255, 255, 255 });
 			}
 		}
-};
\ No newline at end of file
+};
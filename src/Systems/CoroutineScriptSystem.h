@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../ECS/ECS.h"
+#include "../Components/CoroutineScriptComponent.h"
+#include "../ScriptScheduler/ScriptScheduler.h"
+#include <sol/sol.hpp>
+
+// Starts an entity's coroutine script when it appears and drops it with the
+// entity, the scheduler decides which ones run each tick
+class CoroutineScriptSystem: public System {
+	private:
+		ScriptScheduler scheduler;
+
+	public:
+		CoroutineScriptSystem() {
+			RequireComponent<CoroutineScriptComponent>();
+		}
+
+		void CreateLuaBindings(sol::state& lua) {
+			scheduler.CreateLuaBindings(lua);
+		}
+
+		void OnEntityAdded(Entity entity) override {
+			scheduler.Start(entity, entity.GetComponent<CoroutineScriptComponent>().func);
+		}
+
+		void OnEntityRemoved(Entity entity) override {
+			scheduler.Stop(entity);
+		}
+
+		void Update(double dt) {
+			scheduler.Update(dt);
+		}
+
+		ScriptSchedulerStats GetStats() const {
+			return scheduler.GetStats();
+		}
+};
@@ -8,14 +8,23 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/ProjectileEmitterComponent.h"
 #include "../Components/ProjectileComponent.h"
+#include "../SimulationClock/SimulationClock.h"
 
 class ProjectileEmitSystem: public System {
+	private:
+		TextureHandle projectileTexture;
+
 	public:
 		ProjectileEmitSystem() {
 			RequireComponent<ProjectileEmitterComponent>();
 			RequireComponent<TransformComponent>();
 		}
 
+		// Resolved once per level load
+		void SetProjectileTexture(TextureHandle texture) {
+			projectileTexture = texture;
+		}
+
 		void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
 			eventBus->SubscribeToEvent<KeyPressedEvent>(
 				this, &ProjectileEmitSystem::OnKeyPressed
@@ -51,7 +60,7 @@ class ProjectileEmitSystem: public System {
 						projectile.Group("projectiles");
 						projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0);
 						projectile.AddComponent<RigidBodyComponent>(projectileVelocity);
-						projectile.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
+						projectile.AddComponent<SpriteComponent>(projectileTexture, 4, 4, 4);
 						projectile.AddComponent<BoxColliderComponent>(4, 4);
 						projectile.AddComponent<ProjectileComponent>(
 							emitter.isFriendly, 
@@ -72,7 +81,7 @@ class ProjectileEmitSystem: public System {
 					continue;
 				}
 
-				if (SDL_GetTicks() - projectileEmitter.lastEmissionTime > projectileEmitter.repeatFrequency) {
+				if (SimulationClock::GetTicks() - projectileEmitter.lastEmissionTime > projectileEmitter.repeatFrequency) {
 					glm::vec2 projectilePosition = transform.position;
 
 					if (entity.HasComponent<SpriteComponent>()) {
@@ -85,7 +94,7 @@ class ProjectileEmitSystem: public System {
 					projectile.Group("projectiles");
 					projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), transform.rotation);
 					projectile.AddComponent<RigidBodyComponent>(projectileEmitter.projectileVelocity);
-					projectile.AddComponent<SpriteComponent>("bullet-texture", 4, 4, 4);
+					projectile.AddComponent<SpriteComponent>(projectileTexture, 4, 4, 4);
 					projectile.AddComponent<BoxColliderComponent>(4, 4);
 					projectile.AddComponent<ProjectileComponent>(
 						projectileEmitter.isFriendly, 
@@ -93,7 +102,7 @@ class ProjectileEmitSystem: public System {
 						projectileEmitter.projectileDuration
 					);
 
-					projectileEmitter.lastEmissionTime = SDL_GetTicks();
+					projectileEmitter.lastEmissionTime = SimulationClock::GetTicks();
 				}
 			}
 		}
@@ -2,6 +2,7 @@
 
 #include "../ECS/ECS.h"
 #include "../Components/ProjectileComponent.h"
+#include "../SimulationClock/SimulationClock.h"
 
 class ProjectileLifecycleSystem: public System {
 	public:
@@ -14,7 +15,7 @@ class ProjectileLifecycleSystem: public System {
 				auto projectile = entity.GetComponent<ProjectileComponent>();
 
 				// TODO kill projectiles after reach duration limit
-				if (SDL_GetTicks() - projectile.startTime >= projectile.duration) {
+				if (SimulationClock::GetTicks() - projectile.startTime >= projectile.duration) {
 					entity.Kill();
 				}
 			}
@@ -1,14 +1,105 @@
 #pragma once
 
 #include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Renderer/RenderCommandList.h"
+#include "../ScriptProfiler/ScriptProfiler.h"
+#include "../Game/LuaGarbageStepper.h"
 #include <imgui/imgui.h>
-#include <imgui/imgui_sdl.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+enum ScriptColumn {
+	SCRIPT_COLUMN_NAME,
+	SCRIPT_COLUMN_ENTITIES,
+	SCRIPT_COLUMN_LAST,
+	SCRIPT_COLUMN_AVERAGE,
+	SCRIPT_COLUMN_MAX,
+	SCRIPT_COLUMN_DEFERRED,
+	NUM_SCRIPT_COLUMNS
+};
+
+const char* const SCRIPT_COLUMN_NAMES[NUM_SCRIPT_COLUMNS] = { "script", "entities", "last ms", "avg ms", "max ms", "deferred" };
 
 class RenderGUISystem: public System {
+	private:
+		// clicking a column header sorts by it, clicking it again flips the order
+		int scriptSortColumn = SCRIPT_COLUMN_AVERAGE;
+		bool isScriptSortDescending = true;
+
+		static double GetSortValue(const ScriptProfile& profile, int column) {
+			switch (column) {
+				case SCRIPT_COLUMN_ENTITIES: return profile.numEntities;
+				case SCRIPT_COLUMN_LAST: return profile.lastMs;
+				case SCRIPT_COLUMN_MAX: return profile.maxMs;
+				case SCRIPT_COLUMN_DEFERRED: return profile.totalDeferred;
+				default: return profile.averageMs;
+			}
+		}
+
+		void RenderScripts(const ScriptProfiler& profiler, const LuaGarbageStats& garbage) {
+			if (ImGui::Begin("Scripts")) {
+				const ScriptTickStats tick = profiler.GetTickStats();
+				if (tick.budgetMs > 0.0) {
+					ImGui::Text("%.3f ms of %.3f ms budget, %d run, %d deferred", tick.lastMs, tick.budgetMs, tick.numRun, tick.numDeferred);
+				} else {
+					ImGui::Text("%.3f ms, %d run, no budget", tick.lastMs, tick.numRun);
+				}
+				ImGui::Text("Lua %d KB, GC %d steps in %.3f ms%s, %d cycles", garbage.memoryKb, garbage.numSteps, garbage.stepMs, garbage.isCatchingUp ? " (catching up)" : "", garbage.numCycles);
+				ImGui::Separator();
+
+				std::vector<ScriptProfile> profiles = profiler.GetProfiles();
+				std::sort(profiles.begin(), profiles.end(), [this](const ScriptProfile& a, const ScriptProfile& b) {
+					if (scriptSortColumn == SCRIPT_COLUMN_NAME) {
+						return isScriptSortDescending ? a.name > b.name : a.name < b.name;
+					}
+					const double valueA = GetSortValue(a, scriptSortColumn);
+					const double valueB = GetSortValue(b, scriptSortColumn);
+					return isScriptSortDescending ? valueA > valueB : valueA < valueB;
+				});
+
+				ImGui::Columns(NUM_SCRIPT_COLUMNS, "scripts");
+				for (int column = 0; column < NUM_SCRIPT_COLUMNS; column++) {
+					std::string label = SCRIPT_COLUMN_NAMES[column];
+					if (column == scriptSortColumn) {
+						label += isScriptSortDescending ? " v" : " ^";
+					}
+					label += std::string("##") + SCRIPT_COLUMN_NAMES[column]; // same id whatever the arrow
+					if (ImGui::Selectable(label.c_str(), column == scriptSortColumn)) {
+						if (column == scriptSortColumn) {
+							isScriptSortDescending = !isScriptSortDescending;
+						} else {
+							scriptSortColumn = column;
+							isScriptSortDescending = column != SCRIPT_COLUMN_NAME;
+						}
+					}
+					ImGui::NextColumn();
+				}
+				ImGui::Separator();
+				for (const auto& profile: profiles) {
+					ImGui::TextUnformatted(profile.name.c_str());
+					ImGui::NextColumn();
+					ImGui::Text("%d", static_cast<int>(profile.numEntities));
+					ImGui::NextColumn();
+					ImGui::Text("%.3f", profile.lastMs);
+					ImGui::NextColumn();
+					ImGui::Text("%.3f", profile.averageMs);
+					ImGui::NextColumn();
+					ImGui::Text("%.3f", profile.maxMs);
+					ImGui::NextColumn();
+					ImGui::Text("%d", profile.totalDeferred);
+					ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+			}
+			ImGui::End();
+		}
+
 	public:
 		RenderGUISystem() = default;
 
-		void Update(const std::unique_ptr<Registry>& registry) {
+		void Update(const std::unique_ptr<Registry>& registry, const std::unique_ptr<AssetStore>& assetStore, const ScriptProfiler& scriptProfiler, const LuaGarbageStats& luaGarbage, RenderCommandList& frame) {
 			ImGui::NewFrame();
 
 			// ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_AlwaysAutoResize;
@@ -25,7 +116,7 @@ class RenderGUISystem: public System {
 					tank.Group("enemies");
 					tank.AddComponent<TransformComponent>(glm::vec2(enemyXPos, enemyYPos), glm::vec2(2.0, 2.0), 0.0);
 					tank.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
-					tank.AddComponent<SpriteComponent>("tank-texture", 32, 32, 1);
+					tank.AddComponent<SpriteComponent>(assetStore->GetTextureHandle("tank-texture"), 32, 32, 1);
 					tank.AddComponent<BoxColliderComponent>(32, 32);
 					tank.AddComponent<ProjectileEmitterComponent>(glm::vec2(100.0, 0.0), 5000, 3000, 50, false);
 					tank.AddComponent<HealthComponent>(100);
@@ -33,7 +124,8 @@ class RenderGUISystem: public System {
 				}
 				ImGui::End();
 			}
+			RenderScripts(scriptProfiler, luaGarbage);
 			ImGui::Render();
-			ImGuiSDL::Render(ImGui::GetDrawData());
+			frame.AddGui(ImGui::GetDrawData());
 		}
 };
\ No newline at end of file
@@ -1,13 +1,70 @@
 #pragma once
 
 #include "../ECS/ECS.h"
-#include "../AssetStore/AssetStore.h"
 #include "../Components/HealthComponent.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
+#include "../Renderer/RenderCommandList.h"
 #include <SDL2/SDL.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class RenderHealthBarSystem: public System {
+	private:
+		// What a health value looks like, only worked out again when it changes
+		struct HealthLabel {
+			int healthPercentage;
+			const std::string* text;	// one of the shared labels, or nullptr
+			std::string ownText;		// a value outside 0..100, copied per frame
+			SDL_Color color;
+		};
+
+		static constexpr int MAX_SHARED_LABEL = 100;
+
+		FontHandle labelFont;
+		std::unordered_map<size_t, HealthLabel> labels; // by entity id
+
+		// "0".."100", never freed so the render thread can draw them any time
+		static const std::vector<std::string>& GetSharedLabels() {
+			static const std::vector<std::string>* sharedLabels = [] {
+				auto result = new std::vector<std::string>();
+				for (int hp = 0; hp <= MAX_SHARED_LABEL; hp++) {
+					result->push_back(std::to_string(hp));
+				}
+				return result;
+			}();
+			return *sharedLabels;
+		}
+
+		static void BuildLabel(HealthLabel& label, int hp) {
+			label.healthPercentage = hp;
+			label.color = { 0, 255, 0, 255 };
+			if (hp >= 33 && hp < 66) {
+				label.color = { 255, 255, 0, 255 };
+			} else if (hp < 33) {
+				label.color = { 255, 0, 0, 255 };
+			}
+			if (hp >= 0 && hp <= MAX_SHARED_LABEL) {
+				label.text = &GetSharedLabels()[hp];
+				label.ownText.clear();
+			} else {
+				label.text = nullptr;
+				label.ownText = std::to_string(hp);
+			}
+		}
+
+		const HealthLabel& GetLabel(Entity entity, int hp) {
+			auto it = labels.find(entity.GetId());
+			if (it == labels.end()) {
+				it = labels.emplace(entity.GetId(), HealthLabel()).first;
+				BuildLabel(it->second, hp);
+			} else if (it->second.healthPercentage != hp) {
+				BuildLabel(it->second, hp);
+			}
+			return it->second;
+		}
+
 	public:
 		RenderHealthBarSystem() {
 			RequireComponent<HealthComponent>();
@@ -15,54 +72,41 @@ class RenderHealthBarSystem: public System {
 			RequireComponent<SpriteComponent>();
 		}
 
-		void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
-			for (auto entity: GetSystemEntities()) {
-				const auto health = entity.GetComponent<HealthComponent>();
-				const auto transform = entity.GetComponent<TransformComponent>();
-				const auto sprite = entity.GetComponent<SpriteComponent>();
+		// Resolved once per level load
+		void SetLabelFont(FontHandle font) {
+			labelFont = font;
+		}
 
-				SDL_Color healthBarColor = { 0, 255, 0 };
+		void OnEntityRemoved(Entity entity) override {
+			labels.erase(entity.GetId());
+		}
+
+		void Update(RenderCommandList& frame, const SDL_Rect& camera, double interpolationAlpha) {
+			for (auto entity: GetSystemEntities()) {
+				const auto& health = entity.GetComponent<HealthComponent>();
+				const auto& transform = entity.GetComponent<TransformComponent>();
+				const auto& sprite = entity.GetComponent<SpriteComponent>();
+				const glm::vec2 position = transform.GetInterpolatedPosition(interpolationAlpha);
 
 				int hp = health.healthPercentage;
-				if (hp >= 33 && hp < 66) {
-					healthBarColor = { 255, 255, 0 };
-				} else if (hp < 33) {
-					healthBarColor = { 255, 0, 0 };
-				}
+				const HealthLabel& label = GetLabel(entity, hp);
+				const SDL_Color& healthBarColor = label.color;
 
 				// Render Health Percentage
-
-				SDL_Surface* surface = TTF_RenderText_Blended(
-					assetStore->GetFont("pico8-font-5"), 
-					std::to_string(health.healthPercentage).c_str(), 
-					healthBarColor
-				);
-				SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-				SDL_FreeSurface(surface);
-
-				int labelWidth = 0;
-				int labelHeight = 0;
-
-				SDL_QueryTexture(texture, NULL, NULL, &labelWidth, &labelHeight);
-
-				double labelPosX = (transform.position.x) + (sprite.width * transform.scale.x / 2) - 5 - camera.x;
-				double labelPosY = (transform.position.y) - 20 - camera.y;
-				SDL_Rect dstRectLabel = {
-					static_cast<int>(labelPosX),
-					static_cast<int>(labelPosY),
-					labelWidth,
-					labelHeight
-				};
-				SDL_RenderCopy(renderer, texture, NULL, &dstRectLabel);
-
-				SDL_DestroyTexture(texture);
+				double labelPosX = (position.x) + (sprite.width * transform.scale.x / 2) - 5 - camera.x;
+				double labelPosY = (position.y) - 20 - camera.y;
+				if (label.text) {
+					frame.AddLabel(labelFont, *label.text, healthBarColor, static_cast<int>(labelPosX), static_cast<int>(labelPosY));
+				} else {
+					frame.AddText(labelFont, label.ownText, healthBarColor, static_cast<int>(labelPosX), static_cast<int>(labelPosY));
+				}
 
 				// Render Health Bar
 
 				int barWidth = sprite.width * transform.scale.x;
 				int barHeight = sprite.height / 5;
-				double healthBarPosX = (transform.position.x) - camera.x;
-				double healthBarPosY = (transform.position.y) - 5 - camera.y;
+				double healthBarPosX = (position.x) - camera.x;
+				double healthBarPosY = (position.y) - 5 - camera.y;
 
 				SDL_Rect healthBarRectangle = {
 					static_cast<int>(healthBarPosX),
@@ -70,8 +114,7 @@ class RenderHealthBarSystem: public System {
 					static_cast<int>(barWidth * hp / 100.0),
 					static_cast<int>(barHeight)
 				};
-				SDL_SetRenderDrawColor(renderer, healthBarColor.r, healthBarColor.g, healthBarColor.b, 255);
-				SDL_RenderFillRect(renderer, &healthBarRectangle);
+				frame.AddFillRect(healthBarRectangle, healthBarColor);
 			}
 		}
 };
\ No newline at end of file
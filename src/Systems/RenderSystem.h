@@ -3,84 +3,322 @@
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/ScriptComponent.h"
+#include "../Components/CoroutineScriptComponent.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Renderer/RenderCommandList.h"
+#include "../SpatialGrid/SpatialGrid.h"
 #include <SDL2/SDL.h>
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <functional>
 
 class RenderSystem: public System {
+	private:
+		// Compact draw state of one sprite, refreshed from its components every frame
+		struct RenderRecord {
+			size_t entityId;
+			bool isRemoved;
+			int zIndex;
+			SDL_Texture* texture;
+			SDL_Point atlasOffset;	// where the sprite's image starts in its atlas page
+			SDL_Rect srcRect;
+			float x;	// world position, camera is applied when drawing unless fixed
+			float y;
+			int width;
+			int height;
+			double rotation;
+			SDL_RendererFlip flip;
+			bool isFixed;
+			bool isDynamic;	// may move, bounds are refreshed every frame
+		};
+
+		// Retained render list, always sorted by (zIndex, texture)
+		std::vector<RenderRecord> renderQueue;
+
+		// Entities that joined since the last frame, merged in on the next update
+		std::vector<size_t> pendingEntityIds;
+		std::vector<RenderRecord> pendingRecords;
+
+		// Index of each entity's record in renderQueue [index = entity id], -1 if none
+		std::vector<int> queueIndexPerEntity;
+		size_t numRemovedRecords = 0;
+
+		// Sprites that can move get their grid cells refreshed every frame,
+		// static ones are inserted once. Fixed sprites are always visible.
+		SpatialGrid spatialGrid;
+		std::vector<size_t> dynamicEntityIds;
+		std::vector<size_t> staticEntityIds;
+		std::vector<size_t> fixedEntityIds;
+
+		// Static sprites can still be moved: by another entity's script, through
+		// entity.transform, or by a rigidbody added after they joined. A slice of
+		// them is checked every frame (and the visible ones always), the ones that
+		// moved get their grid cells updated and are treated as dynamic from then on
+		static constexpr size_t STATIC_CHECKS_PER_FRAME = 256;
+		size_t nextStaticCheck = 0;
+		std::vector<size_t> movedEntityIds;
+
+		// Per frame scratch, kept to avoid allocating
+		std::vector<size_t> visibleEntityIds;
+		std::vector<int> visibleQueueIndices;
+
+		Registry* registry = nullptr;
+
+		// How far this frame is between the previous and current simulation tick
+		double interpolationAlpha = 1.0;
+
+		static bool IsDrawnBefore(const RenderRecord& a, const RenderRecord& b) {
+			if (a.zIndex != b.zIndex) {
+				return a.zIndex < b.zIndex;
+			}
+			return std::less<SDL_Texture*>()(a.texture, b.texture);
+		}
+
+		// Copy current component state into the record, returns true if its layer changed
+		bool RefreshRecord(RenderRecord& record) {
+			Entity entity(record.entityId);
+			const auto& transform = registry->GetComponent<TransformComponent>(entity);
+			const auto& sprite = registry->GetComponent<SpriteComponent>(entity);
+
+			record.srcRect = sprite.srcRect;
+			const glm::vec2 position = transform.GetInterpolatedPosition(interpolationAlpha);
+			record.x = position.x;
+			record.y = position.y;
+			record.width = static_cast<int>(sprite.width * transform.scale.x);
+			record.height = static_cast<int>(sprite.height * transform.scale.y);
+			record.rotation = transform.GetInterpolatedRotation(interpolationAlpha);
+			record.flip = sprite.flip;
+			record.isFixed = sprite.isFixed;
+
+			bool hasLayerChanged = record.zIndex != sprite.zIndex;
+			record.zIndex = sprite.zIndex;
+			return hasLayerChanged;
+		}
+
+		static SDL_Rect GetWorldBounds(const RenderRecord& record) {
+			SDL_Rect bounds = { static_cast<int>(record.x), static_cast<int>(record.y), record.width, record.height };
+			return bounds;
+		}
+
+		bool IsDynamic(Entity entity) const {
+			return registry->HasComponent<RigidBodyComponent>(entity) || registry->HasComponent<ScriptComponent>(entity) || registry->HasComponent<CoroutineScriptComponent>(entity);
+		}
+
+		// Refreshes a static record, returns true if its layer changed. One that
+		// moved or can now move goes on movedEntityIds
+		bool RefreshStaticRecord(RenderRecord& record) {
+			const SDL_Rect previousBounds = GetWorldBounds(record);
+			const bool hasLayerChanged = RefreshRecord(record);
+			if (record.isFixed) {
+				return hasLayerChanged;
+			}
+			const SDL_Rect bounds = GetWorldBounds(record);
+			const bool hasMoved = bounds.x != previousBounds.x || bounds.y != previousBounds.y || bounds.w != previousBounds.w || bounds.h != previousBounds.h;
+			if (hasMoved || IsDynamic(Entity(record.entityId))) {
+				spatialGrid.Update(record.entityId, bounds);
+				record.isDynamic = true;
+				movedEntityIds.push_back(record.entityId);
+			}
+			return hasLayerChanged;
+		}
+
+		void PromoteMovedRecords() {
+			for (auto entityId: movedEntityIds) {
+				staticEntityIds.erase(std::remove(staticEntityIds.begin(), staticEntityIds.end(), entityId), staticEntityIds.end());
+				dynamicEntityIds.push_back(entityId);
+			}
+			movedEntityIds.clear();
+		}
+
+		void MergePendingRecords(std::unique_ptr<AssetStore>& assetStore) {
+			pendingRecords.clear();
+			for (auto entityId: pendingEntityIds) {
+				Entity entity(entityId);
+				RenderRecord record = {};
+				record.entityId = entityId;
+				RefreshRecord(record);
+				const auto& region = assetStore->GetTextureRegion(registry->GetComponent<SpriteComponent>(entity).texture);
+				record.texture = region.texture;
+				record.atlasOffset = { region.rect.x, region.rect.y };
+				record.isDynamic = IsDynamic(entity);
+				pendingRecords.push_back(record);
+
+				if (record.isFixed) {
+					fixedEntityIds.push_back(entityId);
+				} else {
+					spatialGrid.Insert(entityId, GetWorldBounds(record));
+					if (record.isDynamic) {
+						dynamicEntityIds.push_back(entityId);
+					} else {
+						staticEntityIds.push_back(entityId);
+					}
+				}
+			}
+			pendingEntityIds.clear();
+			std::stable_sort(pendingRecords.begin(), pendingRecords.end(), IsDrawnBefore);
+
+			// Merge from the back so existing records only move once
+			int queueIndex = static_cast<int>(renderQueue.size()) - 1;
+			int pendingIndex = static_cast<int>(pendingRecords.size()) - 1;
+			renderQueue.resize(renderQueue.size() + pendingRecords.size());
+			int targetIndex = static_cast<int>(renderQueue.size()) - 1;
+			while (pendingIndex >= 0) {
+				if (queueIndex >= 0 && IsDrawnBefore(pendingRecords[pendingIndex], renderQueue[queueIndex])) {
+					renderQueue[targetIndex--] = renderQueue[queueIndex--];
+				} else {
+					renderQueue[targetIndex--] = pendingRecords[pendingIndex--];
+				}
+			}
+		}
+
+		// Only a handful of records change layer at a time, so the queue is nearly
+		// sorted and insertion sort stays close to linear without allocating
+		void ResortQueue() {
+			for (size_t i = 1; i < renderQueue.size(); i++) {
+				RenderRecord record = renderQueue[i];
+				size_t j = i;
+				while (j > 0 && IsDrawnBefore(record, renderQueue[j - 1])) {
+					renderQueue[j] = renderQueue[j - 1];
+					j--;
+				}
+				renderQueue[j] = record;
+			}
+		}
+
+		void RebuildQueueIndices() {
+			std::fill(queueIndexPerEntity.begin(), queueIndexPerEntity.end(), -1);
+			for (size_t i = 0; i < renderQueue.size(); i++) {
+				size_t entityId = renderQueue[i].entityId;
+				if (entityId >= queueIndexPerEntity.size()) {
+					queueIndexPerEntity.resize(entityId + 1, -1);
+				}
+				queueIndexPerEntity[entityId] = static_cast<int>(i);
+			}
+		}
+
 	public:
 		RenderSystem() {
 			RequireComponent<TransformComponent>();
+			RequireComponent<SpriteComponent>();
 		}
 
-		void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, SDL_Rect camera) {
-			// Create vector with both sprite and transform component of each entity
-			struct RenderableEntity {
-				TransformComponent transformComponent;
-				SpriteComponent spriteComponent;
-			};
-			std::vector<RenderableEntity> renderableEntities;
-			for (auto entity: GetSystemEntities()) {
-				RenderableEntity renderableEntity;
-				renderableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
-				renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
-				bool isEntityOutsideCameraView = (
-					renderableEntity.transformComponent.position.x + (renderableEntity.transformComponent.scale.x * renderableEntity.spriteComponent.width) < camera.x ||
-					renderableEntity.transformComponent.position.x > camera.x + camera.w ||
-					renderableEntity.transformComponent.position.y + (renderableEntity.transformComponent.scale.y * renderableEntity.spriteComponent.height) < camera.y ||
-					renderableEntity.transformComponent.position.y > camera.y + camera.h
-				);
-				// except fixed sprites
-				if (isEntityOutsideCameraView && !renderableEntity.spriteComponent.isFixed) {
-					continue;
-				}
-				renderableEntities.emplace_back(renderableEntity);
+		void OnEntityAdded(Entity entity) override {
+			registry = entity.registry;
+			pendingEntityIds.push_back(entity.GetId());
+		}
+
+		void OnEntityRemoved(Entity entity) override {
+			const size_t entityId = entity.GetId();
+			pendingEntityIds.erase(std::remove(pendingEntityIds.begin(), pendingEntityIds.end(), entityId), pendingEntityIds.end());
+			dynamicEntityIds.erase(std::remove(dynamicEntityIds.begin(), dynamicEntityIds.end(), entityId), dynamicEntityIds.end());
+			staticEntityIds.erase(std::remove(staticEntityIds.begin(), staticEntityIds.end(), entityId), staticEntityIds.end());
+			fixedEntityIds.erase(std::remove(fixedEntityIds.begin(), fixedEntityIds.end(), entityId), fixedEntityIds.end());
+			spatialGrid.Remove(entityId);
+			if (entityId < queueIndexPerEntity.size() && queueIndexPerEntity[entityId] >= 0) {
+				// leave a tombstone, the queue is compacted on the next update
+				renderQueue[queueIndexPerEntity[entityId]].isRemoved = true;
+				queueIndexPerEntity[entityId] = -1;
+				numRemovedRecords++;
+			}
+		}
+
+		void Update(RenderCommandList& frame, std::unique_ptr<AssetStore>& assetStore, SDL_Rect camera, double interpolationAlpha) {
+			this->interpolationAlpha = interpolationAlpha;
+			bool hasQueueChanged = false;
+
+			if (numRemovedRecords > 0) {
+				renderQueue.erase(std::remove_if(renderQueue.begin(), renderQueue.end(), [](const RenderRecord& record) {
+					return record.isRemoved;
+				}), renderQueue.end());
+				numRemovedRecords = 0;
+				hasQueueChanged = true;
 			}
 
-			// Sort entities of system by z index
-			std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity a, const RenderableEntity b) {
-				return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
-			});
+			if (!pendingEntityIds.empty()) {
+				MergePendingRecords(assetStore);
+				hasQueueChanged = true;
+			}
 
+			if (hasQueueChanged) {
+				RebuildQueueIndices();
+			}
 
-			// my sort by z index
-			// std::vector<Entity> entities = GetSystemEntities();
-			// std::sort(entities.begin(), entities.end(), [](const Entity a, const Entity b) {
-			// 	return a.GetComponent<SpriteComponent>().zIndex < b.GetComponent<SpriteComponent>().zIndex;
-			// });
+			// Moving sprites refresh their state and grid cells every frame
+			bool hasLayerChanged = false;
+			for (auto entityId: dynamicEntityIds) {
+				auto& record = renderQueue[queueIndexPerEntity[entityId]];
+				hasLayerChanged |= RefreshRecord(record);
+				spatialGrid.Update(entityId, GetWorldBounds(record));
+			}
 
-			for (auto entity: renderableEntities) {
-			// for (auto entity: entities) {
-				// Update entity sys based on velocity for every frame
-				auto& transform = entity.transformComponent;
-				const auto& sprite = entity.spriteComponent;
+			// A slice of the static sprites, so one moved off camera is found
+			// before the camera gets to where it went
+			const size_t numStaticChecks = std::min(STATIC_CHECKS_PER_FRAME, staticEntityIds.size());
+			for (size_t i = 0; i < numStaticChecks; i++) {
+				nextStaticCheck = nextStaticCheck < staticEntityIds.size() ? nextStaticCheck : 0;
+				auto& record = renderQueue[queueIndexPerEntity[staticEntityIds[nextStaticCheck++]]];
+				if (!record.isDynamic) {
+					hasLayerChanged |= RefreshStaticRecord(record);
+				}
+			}
 
-				// my sort
-				// auto& transform = entity.GetComponent<TransformComponent>();
-				// const auto& sprite = entity.GetComponent<SpriteComponent>();
+			// Only cells overlapping the camera are visited, static sprites are
+			// refreshed once they turn out to be visible
+			visibleEntityIds.clear();
+			spatialGrid.Query(camera, visibleEntityIds);
+			visibleEntityIds.insert(visibleEntityIds.end(), fixedEntityIds.begin(), fixedEntityIds.end());
+			for (auto entityId: visibleEntityIds) {
+				auto& record = renderQueue[queueIndexPerEntity[entityId]];
+				if (!record.isDynamic) {
+					hasLayerChanged |= RefreshStaticRecord(record);
+				}
+			}
+			PromoteMovedRecords();
 
-				// Set source rect of original sprite texture
-				SDL_Rect srcRect = sprite.srcRect;
+			if (hasLayerChanged) {
+				ResortQueue();
+				RebuildQueueIndices();
+			}
 
-				// Set the dest rect with the x,y pos to be rendered
-				SDL_Rect dstRect = {
-					static_cast<int>(transform.position.x - (sprite.isFixed ? 0 : camera.x)),
-					static_cast<int>(transform.position.y - (sprite.isFixed ? 0 : camera.y)),
-					static_cast<int>(sprite.width * transform.scale.x), 
-					static_cast<int>(sprite.height * transform.scale.y)
-				};
+			// Queue position is draw order, so sorting the visible indices is enough
+			visibleQueueIndices.clear();
+			for (auto entityId: visibleEntityIds) {
+				visibleQueueIndices.push_back(queueIndexPerEntity[entityId]);
+			}
+			std::sort(visibleQueueIndices.begin(), visibleQueueIndices.end());
 
-				SDL_RenderCopyEx(
-					renderer, 
-					assetStore->GetTexture(sprite.assetId),
-					&srcRect, &dstRect, 
-					transform.rotation, NULL,
-					sprite.flip
+			// Queue is already in draw order, cull and record it for the batch
+			for (auto queueIndex: visibleQueueIndices) {
+				const auto& record = renderQueue[queueIndex];
+				bool isEntityOutsideCameraView = (
+					record.x + record.width < camera.x ||
+					record.x > camera.x + camera.w ||
+					record.y + record.height < camera.y ||
+					record.y > camera.y + camera.h
 				);
+				// except fixed sprites
+				if (isEntityOutsideCameraView && !record.isFixed) {
+					continue;
+				}
 
-				// Draw PNG texture
+				SpriteDraw draw;
+				draw.texture = record.texture;
+				draw.zIndex = record.zIndex;
+				draw.srcRect = record.srcRect;
+				draw.srcRect.x += record.atlasOffset.x;
+				draw.srcRect.y += record.atlasOffset.y;
+				draw.dstRect = {
+					static_cast<int>(record.x - (record.isFixed ? 0 : camera.x)),
+					static_cast<int>(record.y - (record.isFixed ? 0 : camera.y)),
+					record.width,
+					record.height
+				};
+				draw.rotation = record.rotation;
+				draw.flip = record.flip;
+				frame.AddSprite(draw);
 			}
 		}
-};
\ No newline at end of file
+};
@@ -1,8 +1,8 @@
 #pragma once
 
 #include "../ECS/ECS.h"
-#include "../AssetStore/AssetStore.h"
 #include "../Components/TextLabelComponent.h"
+#include "../Renderer/RenderCommandList.h"
 #include <SDL2/SDL.h>
 
 class RenderTextSystem: public System {
@@ -11,32 +11,18 @@ class RenderTextSystem: public System {
 			RequireComponent<TextLabelComponent>();
 		}
 
-		void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
+		void Update(RenderCommandList& frame, const SDL_Rect& camera) {
 			for (auto entity: GetSystemEntities()) {
-				const auto textlabel = entity.GetComponent<TextLabelComponent>();
+				const auto& textlabel = entity.GetComponent<TextLabelComponent>();
 
-				SDL_Surface* surface = TTF_RenderText_Blended(
-					assetStore->GetFont(textlabel.assetId), 
-					textlabel.text.c_str(), 
-					textlabel.color
-				);
-				SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-				SDL_FreeSurface(surface);
-
-				int labelWidth = 0;
-				int labelHeight = 0;
-
-				SDL_QueryTexture(texture, NULL, NULL, &labelWidth, &labelHeight);
-
-				SDL_Rect dstRect = {
+				// Glyphs come from the font's atlas when the frame is drawn, the layout is cached until the text changes
+				frame.AddText(
+					textlabel.font,
+					textlabel.text,
+					textlabel.color,
 					static_cast<int>(textlabel.position.x) - (textlabel.isFixed ? 0 : camera.x),
-					static_cast<int>(textlabel.position.y) - (textlabel.isFixed ? 0 : camera.y),
-					labelWidth,
-					labelHeight
-				};
-				SDL_RenderCopy(renderer, texture, NULL, &dstRect);
-
-				SDL_DestroyTexture(texture);
+					static_cast<int>(textlabel.position.y) - (textlabel.isFixed ? 0 : camera.y)
+				);
 			}
 		}
-};
\ No newline at end of file
+};
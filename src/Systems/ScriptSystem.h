@@ -3,6 +3,19 @@
 #include "../ECS/ECS.h"
 #include "../Components/ScriptComponent.h"
 #include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/ProjectileEmitterComponent.h"
+#include "../Components/AnimationComponent.h"
+#include "../Components/ComponentReflection.h"
+#include "../Logger/Logger.h"
+#include "../ScriptProfiler/ScriptProfiler.h"
+#include <sol/sol.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 // Declare native C++ functions to bind with Lua functions
 std::tuple<double, double> GetEntityPosition(Entity entity) {
@@ -73,7 +86,263 @@ void SetEntityAnimationFrame(Entity entity, int currentFrame) {
 	}
 }
 
+// A usertype with the fields ComponentReflection lists for T, accessed in
+// place: a script reading transform.position.x reads the component itself
+template <typename T>
+sol::usertype<T> BindReflectedType(sol::state& lua) {
+	sol::usertype<T> type = lua.new_usertype<T>(ComponentReflection<T>::name, sol::no_constructor);
+	std::apply([&type](auto... fields) {
+		((type[fields.name] = fields.member), ...);
+	}, ComponentReflection<T>::Fields());
+	return type;
+}
+
+// entity.<name> is the entity's component, or nil without one. It points into
+// the component pool, which moves when components are added or removed, so
+// scripts shouldn't keep it past the call they got it in
+template <typename TComponent>
+void BindComponent(sol::state& lua, sol::usertype<Entity>& entityType) {
+	BindReflectedType<TComponent>(lua);
+	entityType[ComponentReflection<TComponent>::name] = sol::property([](Entity entity) -> TComponent* {
+		return entity.HasComponent<TComponent>() ? &entity.GetComponent<TComponent>() : nullptr;
+	});
+}
+
+// Components a batch packs for its scripts, SCRIPT_BATCH_STRIDE numbers per
+// entity in this order, nil for components the entity doesn't have
+enum ScriptBatchSlot {
+	BATCH_POSITION_X = 1,
+	BATCH_POSITION_Y,
+	BATCH_VELOCITY_X,
+	BATCH_VELOCITY_Y,
+	BATCH_ROTATION,
+	BATCH_PROJECTILE_VELOCITY_X,
+	BATCH_PROJECTILE_VELOCITY_Y,
+	BATCH_ANIMATION_FRAME
+};
+const int SCRIPT_BATCH_STRIDE = 8;
+
+// Runs one script function for a whole batch. The accessor globals are
+// replaced by versions that read and write the packed data of the entity
+// being run, and only go to C++ for any other entity. Each entity's call is
+// protected, one failing script doesn't stop the rest of its batch. No bit
+// operators, LuaJIT has to load this too.
+const char* const SCRIPT_BATCH_RUNNER = R"(
+local native_get_position, native_get_velocity, native_set_position, native_set_velocity,
+	native_set_rotation, native_set_projectile_velocity, native_set_animation_frame, report_error = ...
+local rawequal, pcall, tostring = rawequal, pcall, tostring
+local STRIDE = 8
+local current, base, data
+
+function get_position(entity)
+	if rawequal(entity, current) and data[base + 1] then
+		return data[base + 1], data[base + 2]
+	end
+	return native_get_position(entity)
+end
+
+function get_velocity(entity)
+	if rawequal(entity, current) and data[base + 3] then
+		return data[base + 3], data[base + 4]
+	end
+	return native_get_velocity(entity)
+end
+
+function set_position(entity, x, y)
+	if rawequal(entity, current) and data[base + 1] then
+		data[base + 1], data[base + 2] = x, y
+	else
+		native_set_position(entity, x, y)
+	end
+end
+
+function set_velocity(entity, x, y)
+	if rawequal(entity, current) and data[base + 3] then
+		data[base + 3], data[base + 4] = x, y
+	else
+		native_set_velocity(entity, x, y)
+	end
+end
+
+function set_rotation(entity, rotation)
+	if rawequal(entity, current) and data[base + 5] then
+		data[base + 5] = rotation
+	else
+		native_set_rotation(entity, rotation)
+	end
+end
+
+function set_projectile_velocity(entity, x, y)
+	if rawequal(entity, current) and data[base + 6] then
+		data[base + 6], data[base + 7] = x, y
+	else
+		native_set_projectile_velocity(entity, x, y)
+	end
+end
+
+function set_animation_frame(entity, frame)
+	if rawequal(entity, current) and data[base + 8] then
+		data[base + 8] = frame
+	else
+		native_set_animation_frame(entity, frame)
+	end
+end
+
+return function(func, entities, batchData, count, delta_time, elapsed_time)
+	data = batchData
+	for i = 1, count do
+		current = entities[i]
+		base = (i - 1) * STRIDE
+		local ok, err = pcall(func, current, delta_time, elapsed_time)
+		if not ok then
+			report_error(current, tostring(err))
+		end
+	end
+	current = nil
+end
+)";
+
+////////////////////////////////////////////////////////////////////////////////
+// ScriptSystem
+////////////////////////////////////////////////////////////////////////////////
+// Entities sharing a script function (the same function in the level, or the
+// same chunk in a compiled one) run as one batch: their components are packed
+// into a Lua table, one call runs the function for all of them and the
+// results are copied back after. Scripts reading their own entity stay in
+// Lua, so crossing into C++ is per distinct function rather than per entity
+// and accessor call.
+//
+// Scripts can also reach components in place through entity.transform and
+// the like. Those writes are kept, only values set through the set_ functions
+// are copied back. What get_ functions return for the running entity is as
+// packed, it doesn't see that entity's writes through entity.<component>.
+//
+// With a budget set, batches stop being started once a tick's scripts have
+// run that long. The rest run first on the next tick, with the time they
+// missed added to their delta_time. A batch is never cut short, so one heavy
+// function can still go over.
+////////////////////////////////////////////////////////////////////////////////
 class ScriptSystem: public System {
+	private:
+		struct ScriptBatch {
+			sol::function func;
+			std::vector<Entity> entities;
+			double deferredSeconds;	// ticks the budget skipped it for
+		};
+
+		// Reused frame to frame, a batch lives as long as some entity runs its function
+		std::vector<ScriptBatch> batches;
+		std::unordered_map<const void*, size_t> batchIndices; // function -> batch
+		sol::protected_function runBatch;
+		sol::table batchEntities;
+		sol::table batchData;
+
+		std::vector<double> packedValues; // as packed, to tell what the scripts changed
+
+		double budgetSeconds = 0.0; // 0 runs every batch every tick
+		size_t nextBatch = 0; // first to run next tick, after the ones the budget deferred
+		ScriptProfiler profiler;
+
+		static double GetSecondsSince(std::chrono::steady_clock::time_point startTime) {
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		}
+
+		void PushSlot(lua_State* L, int index, bool hasComponent, double value) {
+			if (hasComponent) {
+				lua_pushnumber(L, value);
+			} else {
+				lua_pushnil(L);
+			}
+			lua_rawseti(L, -2, index);
+			packedValues[index - 1] = value;
+		}
+
+		// Only values a script set are copied back, so fields it wrote through
+		// entity.<component> are kept
+		template <typename T>
+		void PullSlot(lua_State* L, int index, T& field) {
+			lua_rawgeti(L, -1, index);
+			const double value = lua_tonumber(L, -1);
+			lua_pop(L, 1);
+			if (value != packedValues[index - 1]) {
+				field = static_cast<T>(value);
+			}
+		}
+
+		void Pack(const ScriptBatch& batch) {
+			lua_State* L = batchData.lua_state();
+			packedValues.resize(batch.entities.size() * SCRIPT_BATCH_STRIDE);
+			batchData.push();
+			for (size_t i = 0; i < batch.entities.size(); i++) {
+				Entity entity = batch.entities[i];
+				const int base = i * SCRIPT_BATCH_STRIDE;
+				const bool hasTransform = entity.HasComponent<TransformComponent>();
+				const bool hasRigidBody = entity.HasComponent<RigidBodyComponent>();
+				const bool hasEmitter = entity.HasComponent<ProjectileEmitterComponent>();
+				const bool hasAnimation = entity.HasComponent<AnimationComponent>();
+				const TransformComponent* transform = hasTransform ? &entity.GetComponent<TransformComponent>() : nullptr;
+				const RigidBodyComponent* rigidBody = hasRigidBody ? &entity.GetComponent<RigidBodyComponent>() : nullptr;
+				const ProjectileEmitterComponent* emitter = hasEmitter ? &entity.GetComponent<ProjectileEmitterComponent>() : nullptr;
+				const AnimationComponent* animation = hasAnimation ? &entity.GetComponent<AnimationComponent>() : nullptr;
+
+				PushSlot(L, base + BATCH_POSITION_X, hasTransform, hasTransform ? transform->position.x : 0.0);
+				PushSlot(L, base + BATCH_POSITION_Y, hasTransform, hasTransform ? transform->position.y : 0.0);
+				PushSlot(L, base + BATCH_VELOCITY_X, hasRigidBody, hasRigidBody ? rigidBody->velocity.x : 0.0);
+				PushSlot(L, base + BATCH_VELOCITY_Y, hasRigidBody, hasRigidBody ? rigidBody->velocity.y : 0.0);
+				PushSlot(L, base + BATCH_ROTATION, hasTransform, hasTransform ? transform->rotation : 0.0);
+				PushSlot(L, base + BATCH_PROJECTILE_VELOCITY_X, hasEmitter, hasEmitter ? emitter->projectileVelocity.x : 0.0);
+				PushSlot(L, base + BATCH_PROJECTILE_VELOCITY_Y, hasEmitter, hasEmitter ? emitter->projectileVelocity.y : 0.0);
+				PushSlot(L, base + BATCH_ANIMATION_FRAME, hasAnimation, hasAnimation ? animation->currentFrame : 0.0);
+				batchEntities.raw_set(i + 1, entity);
+			}
+			lua_pop(L, 1);
+		}
+
+		void Unpack(const ScriptBatch& batch) {
+			lua_State* L = batchData.lua_state();
+			batchData.push();
+			for (size_t i = 0; i < batch.entities.size(); i++) {
+				Entity entity = batch.entities[i];
+				const int base = i * SCRIPT_BATCH_STRIDE;
+				if (entity.HasComponent<TransformComponent>()) {
+					auto& transform = entity.GetComponent<TransformComponent>();
+					PullSlot(L, base + BATCH_POSITION_X, transform.position.x);
+					PullSlot(L, base + BATCH_POSITION_Y, transform.position.y);
+					PullSlot(L, base + BATCH_ROTATION, transform.rotation);
+				}
+				if (entity.HasComponent<RigidBodyComponent>()) {
+					auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+					PullSlot(L, base + BATCH_VELOCITY_X, rigidBody.velocity.x);
+					PullSlot(L, base + BATCH_VELOCITY_Y, rigidBody.velocity.y);
+				}
+				if (entity.HasComponent<ProjectileEmitterComponent>()) {
+					auto& emitter = entity.GetComponent<ProjectileEmitterComponent>();
+					PullSlot(L, base + BATCH_PROJECTILE_VELOCITY_X, emitter.projectileVelocity.x);
+					PullSlot(L, base + BATCH_PROJECTILE_VELOCITY_Y, emitter.projectileVelocity.y);
+				}
+				if (entity.HasComponent<AnimationComponent>()) {
+					PullSlot(L, base + BATCH_ANIMATION_FRAME, entity.GetComponent<AnimationComponent>().currentFrame);
+				}
+			}
+			lua_pop(L, 1);
+		}
+
+		void RunBatch(const ScriptBatch& batch, double dt, int elapsedTime) {
+			if (!runBatch.valid()) {
+				for (auto entity: batch.entities) {
+					batch.func(entity, dt, elapsedTime); // invoke the sol::function
+				}
+				return;
+			}
+			Pack(batch);
+			sol::protected_function_result result = runBatch(batch.func, batchEntities, batchData, batch.entities.size(), dt, elapsedTime);
+			if (!result.valid()) {
+				sol::error err = result;
+				Logger::Err("Error running entity script: " + std::string(err.what()));
+			}
+			Unpack(batch);
+		}
+
 	public:
 		ScriptSystem() {
 			RequireComponent<ScriptComponent>();
@@ -81,7 +350,7 @@ class ScriptSystem: public System {
 
 		void CreateLuaBindings(sol::state& lua) {
 			// Create "entity" usertype for Lua
-			lua.new_usertype<Entity>(
+			sol::usertype<Entity> entityType = lua.new_usertype<Entity>(
 				"entity", 
 				"get_id", &Entity::GetId,
 				"destroy", &Entity::Kill,
@@ -89,6 +358,18 @@ class ScriptSystem: public System {
 				"belongs_to_group", &Entity::BelongsToGroup
 				);
 
+			// Components by reference, eg entity.transform.position.x
+			BindReflectedType<glm::vec2>(lua);
+			BindReflectedType<SDL_Rect>(lua);
+			BindComponent<TransformComponent>(lua, entityType);
+			BindComponent<RigidBodyComponent>(lua, entityType);
+			BindComponent<SpriteComponent>(lua, entityType);
+			BindComponent<AnimationComponent>(lua, entityType);
+			BindComponent<BoxColliderComponent>(lua, entityType);
+			BindComponent<HealthComponent>(lua, entityType);
+			BindComponent<ProjectileEmitterComponent>(lua, entityType);
+			BindComponent<KeyboardControlComponent>(lua, entityType);
+
 			// Create bindings from C++ to Lua functions
 			lua.set_function("get_position", GetEntityPosition);
 			lua.set_function("get_velocity", GetEntityVelocity);
@@ -97,12 +378,98 @@ class ScriptSystem: public System {
 			lua.set_function("set_rotation", SetEntityRotation);
 			lua.set_function("set_projectile_velocity", SetEntityProjectileVelocity);
 			lua.set_function("set_animation_frame", SetEntityAnimationFrame);
+
+			// The batch runner wraps the functions above, scripts see no difference
+			sol::load_result runner = lua.load(SCRIPT_BATCH_RUNNER, "script batch runner");
+			if (!runner.valid()) {
+				sol::error err = runner;
+				Logger::Err("Could not load the script batch runner: " + std::string(err.what()));
+				return;
+			}
+			sol::protected_function setup = runner;
+			sol::protected_function_result result = setup(
+				lua["get_position"], lua["get_velocity"], lua["set_position"], lua["set_velocity"],
+				lua["set_rotation"], lua["set_projectile_velocity"], lua["set_animation_frame"],
+				[](Entity entity, const std::string& message) {
+					Logger::Err("Error running script of entity " + std::to_string(entity.GetId()) + ": " + message);
+				}
+			);
+			if (!result.valid()) {
+				sol::error err = result;
+				Logger::Err("Could not set up the script batch runner: " + std::string(err.what()));
+				return;
+			}
+			runBatch = result;
+			batchEntities = lua.create_table();
+			batchData = lua.create_table();
+		}
+
+		void SetBudget(double seconds) {
+			budgetSeconds = seconds;
+		}
+
+		const ScriptProfiler& GetProfiler() const {
+			return profiler;
 		}
 
 		void Update(double dt, int elapsedTime) {
+			const auto tickStartTime = std::chrono::steady_clock::now();
+			for (auto& batch: batches) {
+				batch.entities.clear();
+			}
 			for (auto entity: GetSystemEntities()) {
-				const auto script = entity.GetComponent<ScriptComponent>();
-				script.func(entity, dt, elapsedTime); // invoke the sol::function
+				const auto& script = entity.GetComponent<ScriptComponent>();
+				auto found = batchIndices.find(script.func.pointer());
+				if (found == batchIndices.end()) {
+					found = batchIndices.emplace(script.func.pointer(), batches.size()).first;
+					batches.push_back({ script.func, {}, 0.0 });
+				}
+				batches[found->second].entities.push_back(entity);
 			}
+
+			// functions no entity runs any more are let go
+			const size_t numBatches = batches.size();
+			batches.erase(std::remove_if(batches.begin(), batches.end(), [this](const ScriptBatch& batch) {
+				if (batch.entities.empty()) {
+					profiler.Forget(batch.func);
+					return true;
+				}
+				return false;
+			}), batches.end());
+			if (batches.size() != numBatches) {
+				batchIndices.clear();
+				for (size_t i = 0; i < batches.size(); i++) {
+					batchIndices.emplace(batches[i].func.pointer(), i);
+				}
+				nextBatch = 0;
+			}
+
+			// From where the last tick stopped, at least one batch a tick
+			size_t numRun = 0;
+			for (; numRun < batches.size(); numRun++) {
+				if (numRun > 0 && budgetSeconds > 0.0 && GetSecondsSince(tickStartTime) >= budgetSeconds) {
+					break;
+				}
+				ScriptBatch& batch = batches[(nextBatch + numRun) % batches.size()];
+				const auto startTime = std::chrono::steady_clock::now();
+				RunBatch(batch, dt + batch.deferredSeconds, elapsedTime);
+				batch.deferredSeconds = 0.0;
+				profiler.AddRun(batch.func, batch.entities.size(), GetSecondsSince(startTime));
+			}
+			for (size_t i = numRun; i < batches.size(); i++) {
+				ScriptBatch& batch = batches[(nextBatch + i) % batches.size()];
+				batch.deferredSeconds += dt;
+				profiler.AddDeferred(batch.func, batch.deferredSeconds);
+			}
+			if (!batches.empty()) {
+				nextBatch = (nextBatch + numRun) % batches.size();
+			}
+
+			ScriptTickStats stats;
+			stats.lastMs = GetSecondsSince(tickStartTime) * 1000.0;
+			stats.budgetMs = budgetSeconds * 1000.0;
+			stats.numRun = numRun;
+			stats.numDeferred = batches.size() - numRun;
+			profiler.SetTickStats(stats);
 		}
-};
\ No newline at end of file
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../ECS/ECS.h"
+#include "../Components/StreamedComponent.h"
+#include "../Components/TransformComponent.h"
+
+// Entities currently spawned from level regions. The LevelStreamer walks
+// these to find the ones standing in regions that went dormant
+class StreamingSystem: public System {
+	public:
+		StreamingSystem() {
+			RequireComponent<TransformComponent>();
+			RequireComponent<StreamedComponent>();
+		}
+};
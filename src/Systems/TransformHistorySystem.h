@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+
+// Runs first in every fixed tick: remembers where everything was, so frames
+// drawn between ticks can blend from there to the new state
+class TransformHistorySystem: public System {
+	public:
+		TransformHistorySystem() {
+			RequireComponent<TransformComponent>();
+		}
+
+		void Update() {
+			for (auto entity: GetSystemEntities()) {
+				auto& transform = entity.GetComponent<TransformComponent>();
+				transform.previousPosition = transform.position;
+				transform.previousRotation = transform.rotation;
+			}
+		}
+};
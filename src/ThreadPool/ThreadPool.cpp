@@ -0,0 +1,136 @@
+#include "ThreadPool.h"
+#include "../Logger/Logger.h"
+#include <atomic>
+#include <algorithm>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t numWorkers) {
+	isStopping = false;
+	for (size_t i = 0; i < numWorkers; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+	Logger::Log("ThreadPool constructor called with " + std::to_string(numWorkers) + " workers.");
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		isStopping = true;
+	}
+	jobsAvailable.notify_all();
+	for (auto& worker: workers) {
+		worker.join();
+	}
+	Logger::Log("ThreadPool destructor called.");
+}
+
+size_t ThreadPool::DefaultNumWorkers() {
+	// leave one hardware thread for the caller, which also works on chunks
+	size_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+size_t ThreadPool::GetNumSlots() const {
+	return workers.size() + 1;
+}
+
+void ThreadPool::WorkerLoop() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(jobsMutex);
+			jobsAvailable.wait(lock, [this]() { return isStopping || !jobs.empty(); });
+			if (isStopping && jobs.empty()) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+void ThreadPool::Enqueue(std::function<void()> job) {
+	if (workers.empty()) {
+		job();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		jobs.push_back(std::move(job));
+	}
+	jobsAvailable.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end, size_t slot)>& fn) {
+	if (count == 0) {
+		return;
+	}
+	grainSize = std::max<size_t>(grainSize, 1);
+	const size_t numChunks = (count + grainSize - 1) / grainSize;
+
+	// not worth waking anyone up, run on the calling thread
+	if (numChunks == 1 || workers.empty()) {
+		fn(0, count, 0);
+		return;
+	}
+
+	// Shared with the helper jobs, which may only get off the queue after this
+	// returns: a worker busy with a long asset decode shouldn't hold the caller
+	// up. Helpers that turn up once the caller closed the loop do nothing.
+	struct Loop {
+		std::atomic<size_t> nextChunk;
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t numRunning;
+		bool isClosed;
+	};
+	auto loop = std::make_shared<Loop>();
+	loop->nextChunk = 0;
+	loop->numRunning = 0;
+	loop->isClosed = false;
+
+	// Chunks are handed out dynamically so uneven chunks still balance out
+	auto runChunks = [loop, numChunks, grainSize, count, &fn](size_t slot) {
+		while (true) {
+			size_t chunk = loop->nextChunk.fetch_add(1);
+			if (chunk >= numChunks) {
+				return;
+			}
+			size_t begin = chunk * grainSize;
+			size_t end = std::min(begin + grainSize, count);
+			fn(begin, end, slot);
+		}
+	};
+
+	const size_t numHelpers = std::min(workers.size(), numChunks - 1);
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		// ahead of the background jobs, the caller is waiting on these
+		for (size_t i = 0; i < numHelpers; i++) {
+			jobs.emplace_front([loop, runChunks, slot = i + 1]() {
+				{
+					std::lock_guard<std::mutex> loopLock(loop->mutex);
+					if (loop->isClosed) {
+						return;
+					}
+					loop->numRunning++;
+				}
+				runChunks(slot);
+				std::lock_guard<std::mutex> loopLock(loop->mutex);
+				if (--loop->numRunning == 0) {
+					loop->done.notify_one();
+				}
+			});
+		}
+	}
+	jobsAvailable.notify_all();
+
+	// caller works on slot 0 while the helpers run
+	runChunks(0);
+
+	// every chunk is handed out by now, only wait for helpers still on one
+	std::unique_lock<std::mutex> loopLock(loop->mutex);
+	loop->isClosed = true;
+	loop->done.wait(loopLock, [&]() { return loop->numRunning == 0; });
+}
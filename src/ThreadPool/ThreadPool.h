@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////
+// ThreadPool
+////////////////////////////////////////////////////////////////////////////////
+// Fixed set of worker threads that pull jobs off a shared queue.
+// ParallelFor splits an index range into chunks; the calling thread works on
+// chunks too, so a pool with N workers runs on N + 1 "slots".
+// The slot index passed to the callback lets callers keep per-thread buffers
+// without locking. ParallelFor helpers go ahead of queued jobs and the caller
+// never waits on one that hadn't started, so background loading can't stall it.
+////////////////////////////////////////////////////////////////////////////////
+class ThreadPool {
+	private:
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> jobs;
+		std::mutex jobsMutex;
+		std::condition_variable jobsAvailable;
+		bool isStopping;
+
+		void WorkerLoop();
+
+	public:
+		ThreadPool(size_t numWorkers = DefaultNumWorkers());
+		~ThreadPool();
+
+		// Number of threads that may run ParallelFor chunks (workers + caller)
+		size_t GetNumSlots() const;
+
+		// Runs job on some worker after the jobs already queued, returns right
+		// away. The caller tracks completion
+		void Enqueue(std::function<void()> job);
+
+		// Blocks until fn(begin, end, slot) has been called for every chunk of [0, count)
+		void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end, size_t slot)>& fn);
+
+		static size_t DefaultNumWorkers();
+};
@@ -0,0 +1,232 @@
+#include "TileMap.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+TileMap::TileMap() {
+	numRows = 0;
+	numCols = 0;
+	tileSize = 0;
+	scale = 1.0;
+	numChunkRows = 0;
+	numChunkCols = 0;
+	Logger::Log("TileMap constructor called.");
+}
+
+TileMap::~TileMap() {
+	Clear();
+	Logger::Log("TileMap destructor called.");
+}
+
+void TileMap::Load(std::vector<uint16_t> tiles, int numRows, int numCols, int tileSize, double scale, TextureHandle tileset) {
+	Clear();
+	this->tiles = std::move(tiles);
+	this->numRows = numRows;
+	this->numCols = numCols;
+	this->tileSize = tileSize;
+	this->scale = scale;
+	this->tileset = tileset;
+
+	numChunkRows = (numRows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	numChunkCols = (numCols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	chunkTextures.assign(numChunkRows * numChunkCols, nullptr);
+	isChunkBaked.assign(numChunkRows * numChunkCols, false);
+
+	Logger::Log("Loaded tilemap " + std::to_string(numCols) + "x" + std::to_string(numRows) + " in " + std::to_string(chunkTextures.size()) + " chunks");
+}
+
+void TileMap::Clear() {
+	InvalidateChunks();
+	tiles.clear();
+	chunkTextures.clear();
+	isChunkBaked.clear();
+	numChunkRows = 0;
+	numChunkCols = 0;
+}
+
+void TileMap::InvalidateChunks() {
+	for (auto& texture: chunkTextures) {
+		if (texture) {
+			SDL_DestroyTexture(texture);
+			texture = nullptr;
+		}
+	}
+	std::fill(isChunkBaked.begin(), isChunkBaked.end(), false);
+	bakedChunks.clear();
+}
+
+int TileMap::GetNumBakedChunks() const {
+	return bakedChunks.size();
+}
+
+uint16_t TileMap::GetTile(int row, int col) const {
+	return tiles[row * numCols + col];
+}
+
+int TileMap::GetWidth() const {
+	return numCols * tileSize * scale;
+}
+
+int TileMap::GetHeight() const {
+	return numRows * tileSize * scale;
+}
+
+// Range of tiles covered by a chunk, edge chunks may be smaller than CHUNK_SIZE
+SDL_Rect TileMap::GetChunkTileRect(int chunkRow, int chunkCol) const {
+	SDL_Rect rect;
+	rect.x = chunkCol * CHUNK_SIZE;
+	rect.y = chunkRow * CHUNK_SIZE;
+	rect.w = std::min(CHUNK_SIZE, numCols - rect.x);
+	rect.h = std::min(CHUNK_SIZE, numRows - rect.y);
+	return rect;
+}
+
+// Tileset may sit anywhere inside an atlas page. A tile past its edges would
+// read whatever is packed next to it, those are skipped like they drew nothing
+// off the end of a standalone tileset
+bool TileMap::GetTileSrcRect(const TextureRegion& tileset, uint16_t tile, SDL_Rect& srcRect) const {
+	const int tileCol = tile % TILESET_COLUMNS;
+	const int tileRow = tile / TILESET_COLUMNS;
+	if (tileSize * (tileCol + 1) > tileset.rect.w || tileSize * (tileRow + 1) > tileset.rect.h) {
+		return false;
+	}
+	srcRect = {
+		tileset.rect.x + tileSize * tileCol,
+		tileset.rect.y + tileSize * tileRow,
+		tileSize,
+		tileSize
+	};
+	return true;
+}
+
+void TileMap::BakeChunk(SDL_Renderer* renderer, const TextureRegion& tileset, int chunkRow, int chunkCol) {
+	const int chunkIndex = chunkRow * numChunkCols + chunkCol;
+	isChunkBaked[chunkIndex] = true;
+	bakedChunks.push_back(chunkIndex);
+
+	// Chunks are baked at tileset resolution and scaled when copied to the screen
+	SDL_Rect tileRect = GetChunkTileRect(chunkRow, chunkCol);
+	SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, tileRect.w * tileSize, tileRect.h * tileSize);
+	if (!texture) {
+		// Renderer without target texture support, chunk falls back to per tile copies
+		Logger::Err("Could not create tilemap chunk texture: " + std::string(SDL_GetError()));
+		return;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+	SDL_SetRenderTarget(renderer, texture);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+	SDL_RenderClear(renderer);
+
+	for (int y = 0; y < tileRect.h; y++) {
+		for (int x = 0; x < tileRect.w; x++) {
+			SDL_Rect srcRect;
+			if (!GetTileSrcRect(tileset, GetTile(tileRect.y + y, tileRect.x + x), srcRect)) {
+				continue;
+			}
+			SDL_Rect dstRect = { x * tileSize, y * tileSize, tileSize, tileSize };
+			SDL_RenderCopy(renderer, tileset.texture, &srcRect, &dstRect);
+		}
+	}
+
+	SDL_SetRenderTarget(renderer, previousTarget);
+	chunkTextures[chunkIndex] = texture;
+}
+
+void TileMap::RenderChunkTiles(SDL_Renderer* renderer, const TextureRegion& tileset, int chunkRow, int chunkCol, const SDL_Rect& camera) {
+	SDL_Rect tileRect = GetChunkTileRect(chunkRow, chunkCol);
+	for (int y = tileRect.y; y < tileRect.y + tileRect.h; y++) {
+		for (int x = tileRect.x; x < tileRect.x + tileRect.w; x++) {
+			SDL_Rect srcRect;
+			if (!GetTileSrcRect(tileset, GetTile(y, x), srcRect)) {
+				continue;
+			}
+			SDL_Rect dstRect = {
+				static_cast<int>(tileSize * scale * x) - camera.x,
+				static_cast<int>(tileSize * scale * y) - camera.y,
+				static_cast<int>(tileSize * scale),
+				static_cast<int>(tileSize * scale)
+			};
+			SDL_RenderCopy(renderer, tileset.texture, &srcRect, &dstRect);
+		}
+	}
+}
+
+void TileMap::Render(SDL_Renderer* renderer, const std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
+	if (tiles.empty()) {
+		return;
+	}
+	const TextureRegion& tileset = assetStore->GetTextureRegion(this->tileset);
+
+	// Only chunks that overlap the camera are visited
+	int firstChunkRow, firstChunkCol, lastChunkRow, lastChunkCol;
+	GetChunkRange(camera, 0, firstChunkRow, firstChunkCol, lastChunkRow, lastChunkCol);
+
+	for (int chunkRow = firstChunkRow; chunkRow <= lastChunkRow; chunkRow++) {
+		for (int chunkCol = firstChunkCol; chunkCol <= lastChunkCol; chunkCol++) {
+			const int chunkIndex = chunkRow * numChunkCols + chunkCol;
+			if (!isChunkBaked[chunkIndex]) {
+				BakeChunk(renderer, tileset, chunkRow, chunkCol);
+			}
+
+			SDL_Texture* texture = chunkTextures[chunkIndex];
+			if (!texture) {
+				RenderChunkTiles(renderer, tileset, chunkRow, chunkCol, camera);
+				continue;
+			}
+
+			// Edges come from the same rounding as single tiles so chunks never leave seams
+			SDL_Rect tileRect = GetChunkTileRect(chunkRow, chunkCol);
+			const int left = static_cast<int>(tileSize * scale * tileRect.x);
+			const int top = static_cast<int>(tileSize * scale * tileRect.y);
+			const int right = static_cast<int>(tileSize * scale * (tileRect.x + tileRect.w));
+			const int bottom = static_cast<int>(tileSize * scale * (tileRect.y + tileRect.h));
+			SDL_Rect dstRect = { left - camera.x, top - camera.y, right - left, bottom - top };
+			SDL_RenderCopy(renderer, texture, NULL, &dstRect);
+		}
+	}
+	StreamChunks(renderer, tileset, camera);
+}
+
+void TileMap::GetChunkRange(const SDL_Rect& camera, int margin, int& firstRow, int& firstCol, int& lastRow, int& lastCol) const {
+	const double chunkWorldSize = CHUNK_SIZE * tileSize * scale;
+	firstCol = std::max(0, static_cast<int>(std::floor(camera.x / chunkWorldSize)) - margin);
+	firstRow = std::max(0, static_cast<int>(std::floor(camera.y / chunkWorldSize)) - margin);
+	lastCol = std::min(numChunkCols - 1, static_cast<int>((camera.x + camera.w) / chunkWorldSize) + margin);
+	lastRow = std::min(numChunkRows - 1, static_cast<int>((camera.y + camera.h) / chunkWorldSize) + margin);
+}
+
+void TileMap::StreamChunks(SDL_Renderer* renderer, const TextureRegion& tileset, const SDL_Rect& camera) {
+	// One chunk the camera is heading for gets baked ahead, spreading the cost over frames
+	int firstRow, firstCol, lastRow, lastCol;
+	GetChunkRange(camera, BAKE_MARGIN, firstRow, firstCol, lastRow, lastCol);
+	bool isBaking = true;
+	for (int chunkRow = firstRow; chunkRow <= lastRow && isBaking; chunkRow++) {
+		for (int chunkCol = firstCol; chunkCol <= lastCol && isBaking; chunkCol++) {
+			if (!isChunkBaked[chunkRow * numChunkCols + chunkCol]) {
+				BakeChunk(renderer, tileset, chunkRow, chunkCol);
+				isBaking = false;
+			}
+		}
+	}
+
+	// and the ones it left behind go
+	GetChunkRange(camera, RELEASE_MARGIN, firstRow, firstCol, lastRow, lastCol);
+	for (size_t i = 0; i < bakedChunks.size();) {
+		const int chunkIndex = bakedChunks[i];
+		const int chunkRow = chunkIndex / numChunkCols;
+		const int chunkCol = chunkIndex % numChunkCols;
+		if (chunkRow >= firstRow && chunkRow <= lastRow && chunkCol >= firstCol && chunkCol <= lastCol) {
+			i++;
+			continue;
+		}
+		if (chunkTextures[chunkIndex]) {
+			SDL_DestroyTexture(chunkTextures[chunkIndex]);
+			chunkTextures[chunkIndex] = nullptr;
+		}
+		isChunkBaked[chunkIndex] = false;
+		bakedChunks[i] = bakedChunks.back();
+		bakedChunks.pop_back();
+	}
+}
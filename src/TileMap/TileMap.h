@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../AssetStore/AssetStore.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// TileMap
+////////////////////////////////////////////////////////////////////////////////
+// Terrain lives outside the ECS: tile indices are kept in a flat row-major
+// grid and drawn in chunks of CHUNK_SIZE x CHUNK_SIZE tiles. Each chunk is
+// baked once into a target texture, so drawing the map costs one copy per
+// visible chunk regardless of how many tiles it holds.
+// Chunk textures follow the camera: one chunk ahead of it is baked per frame,
+// and chunks it left behind are dropped, so their memory depends on the view
+// rather than the size of the map.
+////////////////////////////////////////////////////////////////////////////////
+class TileMap {
+	private:
+		std::vector<uint16_t> tiles;
+		int numRows;
+		int numCols;
+		int tileSize;
+		double scale;
+		TextureHandle tileset;
+
+		// Baked chunk textures, created on first sight [index = chunkRow * numChunkCols + chunkCol]
+		std::vector<SDL_Texture*> chunkTextures;
+		std::vector<bool> isChunkBaked;
+		std::vector<int> bakedChunks;
+		int numChunkRows;
+		int numChunkCols;
+
+		SDL_Rect GetChunkTileRect(int chunkRow, int chunkCol) const;
+		bool GetTileSrcRect(const TextureRegion& tileset, uint16_t tile, SDL_Rect& srcRect) const;
+		void BakeChunk(SDL_Renderer* renderer, const TextureRegion& tileset, int chunkRow, int chunkCol);
+		void RenderChunkTiles(SDL_Renderer* renderer, const TextureRegion& tileset, int chunkRow, int chunkCol, const SDL_Rect& camera);
+		// Chunks overlapping the camera grown by margin chunks on each side
+		void GetChunkRange(const SDL_Rect& camera, int margin, int& firstRow, int& firstCol, int& lastRow, int& lastCol) const;
+		void StreamChunks(SDL_Renderer* renderer, const TextureRegion& tileset, const SDL_Rect& camera);
+
+	public:
+		static const int CHUNK_SIZE = 16;
+		// Chunks within BAKE_MARGIN of the camera are baked ahead, past RELEASE_MARGIN they are dropped
+		static const int BAKE_MARGIN = 1;
+		static const int RELEASE_MARGIN = 2;
+
+		// Tileset images are laid out as rows of 10 tiles
+		static const int TILESET_COLUMNS = 10;
+
+		TileMap();
+		~TileMap();
+
+		void Load(std::vector<uint16_t> tiles, int numRows, int numCols, int tileSize, double scale, TextureHandle tileset);
+		void Clear();
+
+		// Drop baked chunks, eg after the renderer lost its target textures
+		void InvalidateChunks();
+		int GetNumBakedChunks() const;
+
+		uint16_t GetTile(int row, int col) const;
+		int GetWidth() const;
+		int GetHeight() const;
+
+		void Render(SDL_Renderer* renderer, const std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera);
+};
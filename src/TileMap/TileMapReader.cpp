@@ -0,0 +1,160 @@
+#include "TileMapReader.h"
+#include "../AssetStore/MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace {
+	inline bool IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* SkipSpaces(const char* p, const char* end) {
+		while (p < end && IsSpace(*p)) {
+			p++;
+		}
+		return p;
+	}
+
+	inline const char* FindLineEnd(const char* p, const char* end) {
+		const void* newline = std::memchr(p, '\n', end - p);
+		return newline ? static_cast<const char*>(newline) : end;
+	}
+
+	inline const char* NextLine(const char* lineEnd, const char* end) {
+		return lineEnd < end ? lineEnd + 1 : end;
+	}
+
+	// rows = non-blank lines, cols = tiles on the first of them. Only that
+	// line is scanned, Parse widens the grid when a later row is longer.
+	void MeasureMap(const char* text, const char* end, int& numRows, int& numCols) {
+		numRows = 0;
+		numCols = 0;
+		for (const char* line = text; line < end;) {
+			const char* lineEnd = FindLineEnd(line, end);
+			const char* p = SkipSpaces(line, lineEnd);
+			if (p < lineEnd) {
+				if (numRows == 0) {
+					const char* last = lineEnd;
+					while (IsSpace(*(last - 1))) {
+						last--;
+					}
+					// a trailing comma doesn't start another tile
+					numCols = 1 + static_cast<int>(std::count(p, last, ',')) - (*(last - 1) == ',' ? 1 : 0);
+				}
+				numRows++;
+			}
+			line = NextLine(lineEnd, end);
+		}
+	}
+
+	void WidenGrid(std::vector<uint16_t>& tiles, int numRows, int numCols, int newNumCols) {
+		std::vector<uint16_t> wider(static_cast<size_t>(numRows) * newNumCols, 0);
+		for (int row = 0; row < numRows; row++) {
+			std::copy_n(tiles.begin() + static_cast<size_t>(row) * numCols, numCols, wider.begin() + static_cast<size_t>(row) * newNumCols);
+		}
+		tiles.swap(wider);
+	}
+
+	// One line into rowTiles, p on its first tile. Finds the end of the line
+	// as it goes, no separate scan for it. Returns how many tiles the line has,
+	// or -1 with errorAt and message set.
+	int ParseRow(const char* p, const char* end, uint16_t* rowTiles, int numCols, const char*& lineEnd, const char*& errorAt, const char*& message) {
+		int col = 0;
+		while (true) {
+			unsigned int value = 0;
+			const auto [next, result] = std::from_chars(p, end, value);
+			if (result != std::errc() || value > std::numeric_limits<uint16_t>::max()) {
+				errorAt = p;
+				message = result == std::errc::invalid_argument ? "expected a tile index" : "tile index out of range";
+				return -1;
+			}
+			if (col < numCols) {
+				rowTiles[col] = static_cast<uint16_t>(value);
+			}
+			col++;
+
+			// "1,2,3" is the common case, spaces only get looked for when it isn't
+			p = next;
+			if (p < end && *p != ',') {
+				p = SkipSpaces(p, end);
+			}
+			if (p < end && *p == ',') {
+				p++;
+				if (p < end && static_cast<unsigned char>(*p - '0') < 10) {
+					continue;
+				}
+				p = SkipSpaces(p, end);
+				if (p < end && *p != '\n') {
+					continue;
+				}
+			} else if (p < end && *p != '\n') {
+				errorAt = p;
+				message = "expected ','";
+				return -1;
+			}
+			lineEnd = p;
+			return col;
+		}
+	}
+}
+
+void TileMapReader::SetError(const std::string& source, int row, int col, const std::string& message) {
+	error = source + ":" + std::to_string(row) + ":" + std::to_string(col) + ": " + message;
+}
+
+const std::string& TileMapReader::GetError() const {
+	return error;
+}
+
+bool TileMapReader::Read(const std::string& filePath, int& numRows, int& numCols, std::vector<uint16_t>& tiles) {
+	MappedFile file;
+	if (!file.Open(filePath)) {
+		error = filePath + ": could not open the tilemap";
+		return false;
+	}
+	return Parse(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), numRows, numCols, tiles, filePath);
+}
+
+bool TileMapReader::Parse(const char* text, size_t size, int& numRows, int& numCols, std::vector<uint16_t>& tiles, const std::string& source) {
+	error.clear();
+	const char* end = text + size;
+	const bool isWidthFromFile = numCols <= 0;
+	if (numRows <= 0 || numCols <= 0) {
+		int fileRows = 0;
+		int fileCols = 0;
+		MeasureMap(text, end, fileRows, fileCols);
+		numRows = numRows > 0 ? numRows : fileRows;
+		numCols = numCols > 0 ? numCols : fileCols;
+	}
+	tiles.assign(static_cast<size_t>(numRows) * numCols, 0);
+
+	int row = 0;
+	int lineNumber = 0;
+	for (const char* line = text; line < end && row < numRows;) {
+		const char* p = SkipSpaces(line, end);
+		lineNumber++;
+		if (p == end || *p == '\n') {
+			line = NextLine(p, end);
+			continue;
+		}
+
+		const char* lineEnd = nullptr;
+		const char* errorAt = nullptr;
+		const char* message = nullptr;
+		const int numTiles = ParseRow(p, end, tiles.data() + static_cast<size_t>(row) * numCols, numCols, lineEnd, errorAt, message);
+		if (numTiles < 0) {
+			SetError(source, lineNumber, static_cast<int>(errorAt - line) + 1, message);
+			return false;
+		}
+		if (numTiles > numCols && isWidthFromFile) {
+			WidenGrid(tiles, numRows, numCols, numTiles);
+			numCols = numTiles;
+			ParseRow(p, end, tiles.data() + static_cast<size_t>(row) * numCols, numCols, lineEnd, errorAt, message);
+		}
+		row++;
+		line = NextLine(lineEnd, end);
+	}
+	return true;
+}
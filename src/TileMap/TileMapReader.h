@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// TileMapReader
+////////////////////////////////////////////////////////////////////////////////
+// Reads .map files: one row of comma separated tile indices per line, blank
+// lines skipped. The file is mapped and parsed in place with std::from_chars
+// straight into a flat row-major uint16 grid, no per line strings, streams or
+// exceptions. tools/TileMapBenchmark.cpp times it on a 4096x4096 map.
+//
+// The grid is numRows x numCols; tiles past the edge are ignored and missing
+// ones stay 0. Pass 0 for either size to take it from the file (rows = lines,
+// cols = longest row). Bad tiles stop the parse, GetError says where.
+////////////////////////////////////////////////////////////////////////////////
+class TileMapReader {
+	private:
+		std::string error;
+
+		void SetError(const std::string& source, int row, int col, const std::string& message);
+
+	public:
+		bool Read(const std::string& filePath, int& numRows, int& numCols, std::vector<uint16_t>& tiles);
+		bool Parse(const char* text, size_t size, int& numRows, int& numCols, std::vector<uint16_t>& tiles, const std::string& source = "map");
+
+		// "<file>:<row>:<col>: <message>", rows and columns counted from 1
+		const std::string& GetError() const;
+};
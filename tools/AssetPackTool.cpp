@@ -0,0 +1,245 @@
+#include "../src/AssetStore/AssetPack.h"
+#include "../src/Logger/Logger.h"
+#include "../src/TileMap/TileMapReader.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// assetpack [--lz4] <out.pack> <dirs or files...>
+////////////////////////////////////////////////////////////////////////////////
+// Offline side of AssetPack. Decodes every image to RGBA32, parses every .map
+// to a tile grid and copies fonts as they are, so the game only has to map the
+// pack and point at it. Run from the repo root so entry names match the asset
+// paths used by the level scripts (eg "assets/images/truck-ford-right.png").
+////////////////////////////////////////////////////////////////////////////////
+
+namespace fs = std::filesystem;
+
+struct PackItem {
+	AssetPackEntry entry;
+	std::vector<char> block;
+};
+
+static std::string Extension(const fs::path& path) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return extension;
+}
+
+static bool ReadImage(const std::string& filePath, PackItem& item) {
+	SDL_Surface* loaded = IMG_Load(filePath.c_str());
+	SDL_Surface* surface = loaded ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0) : nullptr;
+	SDL_FreeSurface(loaded);
+	if (!surface) {
+		Logger::Err("Could not decode " + filePath + ": " + IMG_GetError());
+		return false;
+	}
+	// tight rows, the surface pitch may be padded
+	const size_t rowSize = surface->w * 4;
+	item.entry.type = ASSET_PACK_IMAGE;
+	item.entry.width = surface->w;
+	item.entry.height = surface->h;
+	item.block.resize(rowSize * surface->h);
+	for (int row = 0; row < surface->h; row++) {
+		std::memcpy(item.block.data() + row * rowSize, static_cast<const char*>(surface->pixels) + row * surface->pitch, rowSize);
+	}
+	SDL_FreeSurface(surface);
+	return true;
+}
+
+static bool ReadFont(const std::string& filePath, PackItem& item) {
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		Logger::Err("Could not read " + filePath);
+		return false;
+	}
+	item.entry.type = ASSET_PACK_FONT;
+	item.block.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static bool ReadTileMap(const std::string& filePath, PackItem& item) {
+	TileMapReader reader;
+	int numRows = 0;
+	int numCols = 0;
+	std::vector<uint16_t> tiles;
+	if (!reader.Read(filePath, numRows, numCols, tiles)) {
+		Logger::Err(reader.GetError());
+		return false;
+	}
+	item.entry.type = ASSET_PACK_TILEMAP;
+	item.entry.width = numCols;
+	item.entry.height = numRows;
+	item.block.resize(tiles.size() * sizeof(uint16_t));
+	std::memcpy(item.block.data(), tiles.data(), item.block.size());
+	return true;
+}
+
+static bool AddFile(const fs::path& path, std::vector<PackItem>& items) {
+	const std::string extension = Extension(path);
+	PackItem item;
+	std::memset(&item.entry, 0, sizeof(item.entry));
+
+	bool isRead = false;
+	if (extension == ".png" || extension == ".jpg" || extension == ".jpeg") {
+		isRead = ReadImage(path.string(), item);
+	} else if (extension == ".ttf" || extension == ".otf") {
+		isRead = ReadFont(path.string(), item);
+	} else if (extension == ".map") {
+		isRead = ReadTileMap(path.string(), item);
+	} else {
+		return true; // not something the game loads from a pack
+	}
+	if (!isRead) {
+		return false;
+	}
+
+	const std::string name = AssetPack::NormalizePath(path.generic_string());
+	if (name.size() >= ASSET_PACK_MAX_NAME) {
+		Logger::Err("Asset path too long for the pack: " + name);
+		return false;
+	}
+	std::strncpy(item.entry.name, name.c_str(), ASSET_PACK_MAX_NAME - 1);
+	item.entry.size = item.block.size();
+	items.push_back(std::move(item));
+	return true;
+}
+
+static void Compress(PackItem& item) {
+#ifdef USE_LZ4
+	std::vector<char> compressed(LZ4_compressBound(item.block.size()));
+	const int compressedSize = LZ4_compress_default(item.block.data(), compressed.data(), item.block.size(), compressed.size());
+	if (compressedSize > 0 && static_cast<size_t>(compressedSize) < item.block.size()) {
+		compressed.resize(compressedSize);
+		item.block = std::move(compressed);
+		item.entry.flags |= ASSET_PACK_LZ4;
+	}
+#else
+	(void)item;
+#endif
+}
+
+static uint64_t Align(uint64_t offset) {
+	return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+}
+
+static bool WritePack(const std::string& packPath, std::vector<PackItem>& items) {
+	std::sort(items.begin(), items.end(), [](const PackItem& a, const PackItem& b) {
+		return std::strcmp(a.entry.name, b.entry.name) < 0;
+	});
+
+	AssetPackHeader header;
+	std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+	header.version = ASSET_PACK_VERSION;
+	header.numEntries = items.size();
+	header.reserved = 0;
+
+	uint64_t offset = sizeof(header) + items.size() * sizeof(AssetPackEntry);
+	for (auto& item: items) {
+		offset = Align(offset);
+		item.entry.offset = offset;
+		item.entry.storedSize = item.block.size();
+		offset += item.block.size();
+	}
+
+	std::ofstream file(packPath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		Logger::Err("Could not write " + packPath);
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (const auto& item: items) {
+		file.write(reinterpret_cast<const char*>(&item.entry), sizeof(item.entry));
+	}
+	const char padding[ASSET_PACK_ALIGNMENT] = {};
+	for (const auto& item: items) {
+		file.write(padding, item.entry.offset - file.tellp());
+		file.write(item.block.data(), item.block.size());
+	}
+	return static_cast<bool>(file);
+}
+
+int main(int argc, char* argv[]) {
+	bool isCompressed = false;
+	std::vector<std::string> arguments;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--lz4") {
+			isCompressed = true;
+		} else {
+			arguments.push_back(argv[i]);
+		}
+	}
+	if (arguments.size() < 2) {
+		Logger::Err("Usage: assetpack [--lz4] <out.pack> <dirs or files...>");
+		return 1;
+	}
+#ifndef USE_LZ4
+	if (isCompressed) {
+		Logger::Err("--lz4 ignored, the tool was built without LZ4 (make assetpack LZ4=1)");
+		isCompressed = false;
+	}
+#endif
+
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+	if (SDL_Init(0) != 0 || !IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG)) {
+		Logger::Err("Could not initialize SDL_image");
+		return 1;
+	}
+
+	std::vector<PackItem> items;
+	bool isOk = true;
+	for (size_t i = 1; i < arguments.size() && isOk; i++) {
+		const fs::path input(arguments[i]);
+		if (fs::is_directory(input)) {
+			std::vector<fs::path> files;
+			for (const auto& file: fs::recursive_directory_iterator(input)) {
+				if (file.is_regular_file()) {
+					files.push_back(file.path());
+				}
+			}
+			for (const auto& file: files) {
+				isOk = isOk && AddFile(file, items);
+			}
+		} else {
+			isOk = AddFile(input, items);
+		}
+	}
+	if (isOk && isCompressed) {
+		for (auto& item: items) {
+			Compress(item);
+		}
+	}
+
+	const std::string& packPath = arguments[0];
+	isOk = isOk && WritePack(packPath, items);
+
+	// Read it back the way the game does
+	AssetPack pack;
+	isOk = isOk && pack.Open(packPath) && pack.GetNumEntries() == items.size();
+	if (isOk) {
+		uint64_t size = 0;
+		uint64_t storedSize = 0;
+		for (const auto& item: items) {
+			size += item.entry.size;
+			storedSize += item.entry.storedSize;
+		}
+		Logger::Log("Packed " + std::to_string(items.size()) + " assets into " + packPath + ", " +
+			std::to_string(storedSize / 1024) + " KB stored / " + std::to_string(size / 1024) + " KB unpacked");
+	} else {
+		Logger::Err("Failed to build " + packPath);
+	}
+
+	IMG_Quit();
+	SDL_Quit();
+	return isOk ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include "../src/Game/CompiledLevel.h"
+#include "../src/Game/LevelCompiler.h"
+#include "../src/Game/LuaCompat.h"
+#include "../src/Logger/Logger.h"
+#include <chrono>
+#include <sol/sol.hpp>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+// levelc <LevelN.lua> <LevelN.bin>
+////////////////////////////////////////////////////////////////////////////////
+// Offline side of CompiledLevel. Runs the level script once, in a state set up
+// like the game's, and writes what it describes as a binary level. Run from
+// the repo root so the asset paths in the script resolve. The tile grid is not
+// compiled in, the game reads the map file each time the level loads.
+//
+// Whatever the script works out while it runs is fixed at compile time, eg
+// Level1 picks the day or night tileset from the clock.
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		Logger::Err("Usage: levelc <LevelN.lua> <LevelN.bin>");
+		return 1;
+	}
+	const std::string scriptPath = argv[1];
+	const std::string compiledPath = argv[2];
+
+	sol::state lua;
+	LuaCompat::OpenLibraries(lua);
+
+	CompiledLevel level;
+	if (!LevelCompiler::Compile(lua, scriptPath, level) || !level.Write(compiledPath)) {
+		Logger::Err("Failed to compile " + scriptPath);
+		return 1;
+	}
+
+	// Read it back the way the game does, and time it
+	const auto startTime = std::chrono::steady_clock::now();
+	CompiledLevel readBack;
+	if (!readBack.Read(compiledPath) || readBack.entities.size() != level.entities.size() || readBack.componentData != level.componentData) {
+		Logger::Err("Compiled level " + compiledPath + " does not read back");
+		return 1;
+	}
+	const double readMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	Logger::Log(
+		"Compiled " + scriptPath + " to " + compiledPath + ": " + std::to_string(level.entities.size()) + " entities, " +
+		std::to_string(level.textureAssets.size() + level.fontAssets.size()) + " assets, " + std::to_string(level.scriptChunks.size()) + " scripts, " +
+		std::to_string(level.mapNumCols) + "x" + std::to_string(level.mapNumRows) + " map, reads back in " + std::to_string(readMs) + " ms"
+	);
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include "../src/ECS/ECS.h"
+#include "../src/Game/CompiledLevel.h"
+#include "../src/Game/LevelCompiler.h"
+#include "../src/Game/LuaCompat.h"
+#include "../src/Logger/Logger.h"
+#include "../src/Systems/ScriptSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <sol/sol.hpp>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+// scriptbench [level script] [entities per script] [frames]
+////////////////////////////////////////////////////////////////////////////////
+// Per-frame cost of a level's on_update_scripts (Level1.lua by default) on
+// whichever VM it was built against: make bench-scripts for Lua 5.3, make
+// bench-scripts LUAJIT=1 for LuaJIT. Each script drives its own copies of the
+// entity it was written for, through ScriptSystem as the game runs it. Run
+// from the repo root so the level's paths resolve.
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[]) {
+	const std::string scriptPath = argc > 1 ? argv[1] : "./assets/scripts/Level1.lua";
+	const int numPerScript = argc > 2 ? std::max(1, std::stoi(argv[2])) : 1000;
+	const int numFrames = argc > 3 ? std::max(1, std::stoi(argv[3])) : 600;
+	const double dt = 1.0 / 60.0;
+
+	Registry registry;
+	registry.AddSystem<ScriptSystem>();
+	sol::state lua;
+	LuaCompat::OpenLibraries(lua);
+	registry.GetSystem<ScriptSystem>().CreateLuaBindings(lua);
+
+	CompiledLevel level;
+	if (!LevelCompiler::Compile(lua, scriptPath, level)) {
+		Logger::Err("Could not run " + scriptPath);
+		return 1;
+	}
+	if (level.scriptFunctions.empty()) {
+		Logger::Err(scriptPath + " has no entity scripts");
+		return 1;
+	}
+
+	// all the components the scripts read or set, spread over the map
+	for (const auto& func: level.scriptFunctions) {
+		for (int i = 0; i < numPerScript; i++) {
+			Entity entity = registry.CreateEntity();
+			entity.AddComponent<TransformComponent>(glm::vec2(i % 64 * 32, 10 + i / 64 * 32), glm::vec2(1, 1), 0.0);
+			entity.AddComponent<RigidBodyComponent>(glm::vec2(0, 50));
+			entity.AddComponent<ProjectileEmitterComponent>(glm::vec2(0, 200), 1000, 10000, 10, false);
+			entity.AddComponent<AnimationComponent>(2, 10, true);
+			entity.AddComponent<ScriptComponent>(func);
+		}
+	}
+	registry.Update();
+	const int numEntities = numPerScript * level.scriptFunctions.size();
+
+	// one untimed frame so first-call costs (and the JIT's traces) are out of the way
+	ScriptSystem& scriptSystem = registry.GetSystem<ScriptSystem>();
+	scriptSystem.Update(dt, 0);
+
+	double totalMs = 0.0;
+	double bestMs = 1e30;
+	for (int frame = 1; frame <= numFrames; frame++) {
+		const auto startTime = std::chrono::steady_clock::now();
+		scriptSystem.Update(dt, static_cast<int>(frame * dt * 1000));
+		const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		totalMs += frameMs;
+		bestMs = std::min(bestMs, frameMs);
+	}
+
+	const double averageMs = totalMs / numFrames;
+	Logger::Log(
+		std::string(LuaCompat::GetVM()) + " (" + LevelCompiler::GetLuaVersion(lua) + "): " + std::to_string(level.scriptFunctions.size()) + " scripts x " +
+		std::to_string(numPerScript) + " entities, " + std::to_string(averageMs) + " ms/frame avg, " + std::to_string(bestMs) + " best, " +
+		std::to_string(averageMs * 1000.0 / numEntities) + " us/entity"
+	);
+	return 0;
+}
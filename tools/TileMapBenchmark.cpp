@@ -0,0 +1,114 @@
+#include "../src/Logger/Logger.h"
+#include "../src/TileMap/TileMapReader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// tilemapbench [rows] [cols] [iterations]
+////////////////////////////////////////////////////////////////////////////////
+// Writes a random rows x cols .map (4096x4096 by default) to the temp dir and
+// times TileMapReader::Read on it against the getline/stoi parser the engine
+// used before. Reports MB/s of map text, best of the iterations.
+////////////////////////////////////////////////////////////////////////////////
+
+// the old LevelLoader parser, kept here as the baseline
+static void ReadWithStreams(const std::string& filePath, int numRows, int numCols, std::vector<uint16_t>& tiles) {
+	tiles.assign(numRows * numCols, 0);
+	std::ifstream file(filePath);
+	std::string line;
+	int row = 0;
+	while (std::getline(file, line) && row < numRows) {
+		std::istringstream iss(line);
+		int col = 0;
+		std::string token;
+		while (std::getline(iss, token, ',')) {
+			if (col < numCols) {
+				tiles[row * numCols + col] = std::stoi(token);
+			}
+			col++;
+		}
+		row++;
+	}
+}
+
+template <typename TParse>
+static double BestSeconds(int iterations, TParse parse) {
+	double best = 1e30;
+	for (int i = 0; i < iterations; i++) {
+		const auto startTime = std::chrono::steady_clock::now();
+		parse();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+	return best;
+}
+
+int main(int argc, char* argv[]) {
+	const int numRows = argc > 1 ? std::stoi(argv[1]) : 4096;
+	const int numCols = argc > 2 ? std::stoi(argv[2]) : 4096;
+	const int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+	const std::string filePath = (std::filesystem::temp_directory_path() / "tilemapbench.map").string();
+
+	// tile indices the size of the engine's tilesets, a few wider ones mixed in
+	std::vector<uint16_t> expected(static_cast<size_t>(numRows) * numCols);
+	{
+		std::mt19937 random(42);
+		std::uniform_int_distribution<int> tileIndex(0, 99);
+		std::string text;
+		for (int row = 0; row < numRows; row++) {
+			for (int col = 0; col < numCols; col++) {
+				const uint16_t tile = (col % 64 == 0) ? static_cast<uint16_t>(tileIndex(random) * 600) : static_cast<uint16_t>(tileIndex(random));
+				expected[static_cast<size_t>(row) * numCols + col] = tile;
+				text += std::to_string(tile);
+				text += col + 1 < numCols ? ',' : '\n';
+			}
+		}
+		std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+		file.write(text.data(), text.size());
+		if (!file) {
+			Logger::Err("Could not write " + filePath);
+			return 1;
+		}
+	}
+	std::ifstream sizeCheck(filePath, std::ios::binary | std::ios::ate);
+	const double megabytes = static_cast<double>(sizeCheck.tellg()) / (1024.0 * 1024.0);
+
+	TileMapReader reader;
+	std::vector<uint16_t> tiles;
+	int rows = 0;
+	int cols = 0;
+	bool isRead = true;
+	const double readerSeconds = BestSeconds(iterations, [&]() {
+		rows = 0;
+		cols = 0;
+		isRead = reader.Read(filePath, rows, cols, tiles);
+	});
+	if (!isRead || rows != numRows || cols != numCols || tiles != expected) {
+		Logger::Err("TileMapReader got the map wrong: " + reader.GetError());
+		return 1;
+	}
+
+	std::vector<uint16_t> streamTiles;
+	const double streamSeconds = BestSeconds(1, [&]() {
+		ReadWithStreams(filePath, numRows, numCols, streamTiles);
+	});
+
+	char report[256];
+	std::snprintf(
+		report, sizeof(report),
+		"%dx%d map, %.1f MB: TileMapReader %.1f ms (%.0f MB/s), getline/stoi %.1f ms (%.0f MB/s), %.1fx",
+		numRows, numCols, megabytes,
+		readerSeconds * 1000.0, megabytes / readerSeconds,
+		streamSeconds * 1000.0, megabytes / streamSeconds,
+		streamSeconds / readerSeconds
+	);
+	Logger::Log(report);
+	std::remove(filePath.c_str());
+	return 0;
+}